@@ -0,0 +1,183 @@
+/**
+ * @file Channel.cpp
+ * @brief A bounded channel that passes elements between threads.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include <algorithm>
+#include <cstring>
+#include "Channel.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @brief Constructor.
+ * @param elemSize - in bytes.
+ * @param capacity - in elements.
+ */
+Channel::Channel(size_t elemSize, size_t capacity):
+        _buffer(new char[elemSize * capacity]), _elemSize(elemSize),
+        _capacity(capacity), _head(0), _size(0), _closed(false)
+{
+    _senders.head = _senders.tail = nullptr;
+    _receivers.head = _receivers.tail = nullptr;
+}
+
+/**
+ * @brief Destructor. Frees the buffer.
+ */
+Channel::~Channel()
+{
+    delete[] _buffer;
+}
+
+/**
+ * Passes elements to the waiting receivers, and then to the buffer, as many as
+ * fit.
+ * @param data
+ * @param count - in elements.
+ * @param wake - called for every receiver that got elements.
+ * @return the number of elements that were passed.
+ */
+size_t Channel::send(const char *data, size_t count, void (*wake)(WaitNode *))
+{
+    size_t sent = 0;
+    // receivers only wait while the buffer is empty, so they come first:
+    WaitQueue receivers(&_receivers);
+    while (sent < count && !receivers.empty()) {
+        WaitNode *node = receivers.popFront();
+        ChannelRequest *request = (ChannelRequest *)node->data;
+        size_t num = std::min(count - sent, request->count);
+        memcpy(request->data, data + sent * _elemSize, num * _elemSize);
+        request->done = num;
+        sent += num;
+        wake(node);
+    }
+    return sent + push(data + sent * _elemSize, count - sent);
+}
+
+/**
+ * Takes elements from the buffer, and then directly from the waiting
+ * senders. The buffer is then filled up with the rest of what they send.
+ * @param data
+ * @param count - in elements.
+ * @param wake - called for every sender whose elements were all taken.
+ * @return the number of elements that were taken.
+ */
+size_t Channel::receive(char *data, size_t count, void (*wake)(WaitNode *))
+{
+    size_t received = pop(data, count);
+    // senders only wait while the buffer is full, and what they send comes
+    // after it:
+    WaitQueue senders(&_senders);
+    while (!senders.empty() && (received < count || _size < _capacity)) {
+        WaitNode *node = (WaitNode *)_senders.head;
+        ChannelRequest *request = (ChannelRequest *)node->data;
+        const char *from = request->data + request->done * _elemSize;
+        size_t left = request->count - request->done;
+        size_t num;
+        if (received < count) {
+            // the buffer is empty:
+            num = std::min(left, count - received);
+            memcpy(data + received * _elemSize, from, num * _elemSize);
+            received += num;
+        } else {
+            num = push(from, left);
+        }
+        request->done += num;
+        if (request->done == request->count) {
+            senders.popFront();
+            wake(node);
+        }
+    }
+    return received;
+}
+
+/**
+ * Closes the channel: nothing can be sent anymore, and the elements in the
+ * buffer can still be received.
+ * @param wake - called for every waiting thread.
+ */
+void Channel::close(void (*wake)(WaitNode *))
+{
+    _closed = true;
+    WaitNode *node;
+    while ((node = WaitQueue(&_receivers).popFront())) {
+        wake(node);
+    }
+    while ((node = WaitQueue(&_senders).popFront())) {
+        wake(node);
+    }
+}
+
+/**
+ * @return true if the channel was closed.
+ */
+bool Channel::isClosed()
+{
+    return _closed;
+}
+
+/**
+ * @return true if threads wait in the channel.
+ */
+bool Channel::hasWaiters()
+{
+    return _senders.head || _receivers.head;
+}
+
+/**
+ * @return the size of an element, in bytes.
+ */
+size_t Channel::getElemSize()
+{
+    return _elemSize;
+}
+
+/**
+ * @return the queue of the senders that wait while the buffer is full.
+ */
+uthread_wait_queue_t* Channel::getSenders()
+{
+    return &_senders;
+}
+
+/**
+ * @return the queue of the receivers that wait while the buffer is empty.
+ */
+uthread_wait_queue_t* Channel::getReceivers()
+{
+    return &_receivers;
+}
+
+/**
+ * Copies elements to the end of the buffer, as many as fit. They wrap around
+ * the end of the buffer, so this takes up to two copies.
+ * @return the number of elements that were copied.
+ */
+size_t Channel::push(const char *data, size_t count)
+{
+    size_t num = std::min(count, _capacity - _size);
+    size_t tail = (_head + _size) % (_capacity ? _capacity : 1);
+    size_t first = std::min(num, _capacity - tail);
+    memcpy(_buffer + tail * _elemSize, data, first * _elemSize);
+    memcpy(_buffer, data + first * _elemSize, (num - first) * _elemSize);
+    _size += num;
+    return num;
+}
+
+/**
+ * Copies elements from the front of the buffer, as many as there are.
+ * @return the number of elements that were copied.
+ */
+size_t Channel::pop(char *data, size_t count)
+{
+    size_t num = std::min(count, _size);
+    size_t first = std::min(num, _capacity - _head);
+    memcpy(data, _buffer + _head * _elemSize, first * _elemSize);
+    memcpy(data + first * _elemSize, _buffer, (num - first) * _elemSize);
+    _size -= num;
+    _head = _size ? (_head + num) % _capacity : 0;
+    return num;
+}
@@ -0,0 +1,130 @@
+/**
+ * @file Channel.h
+ * @brief A bounded channel that passes elements between threads.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_CHANNEL_H
+#define EX2_CHANNEL_H
+#include <cstddef>
+#include "WaitQueue.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * What a thread that waits in a channel sends or receives. It lives on the
+ * stack of the thread, and its wait node points to it.
+ */
+struct ChannelRequest
+{
+    char *data;
+    // in elements:
+    size_t count;
+    // the number of elements that were passed while the thread waited:
+    size_t done;
+};
+
+/**
+ * A ring buffer of elements of a fixed size, with the threads that wait to
+ * send to it while it is full, and to receive from it while it is empty.
+ * Elements are passed to and from waiting threads directly: a sender copies
+ * its elements into the requests of the waiting receivers, and a receiver
+ * takes the rest of the waiting senders' elements, so a woken thread never
+ * has to try again. The channel does not block or wake threads itself - it
+ * only removes them from its queues, and its caller does the rest.
+ */
+class Channel
+{
+public:
+    /**
+     * @brief Constructor.
+     * @param elemSize - in bytes.
+     * @param capacity - in elements. A channel with no capacity passes
+     * elements only from a sender to a receiver that waits.
+     */
+    Channel(size_t elemSize, size_t capacity);
+
+    /**
+     * @brief Destructor. Frees the buffer.
+     */
+    ~Channel();
+
+    /**
+     * Passes elements to the waiting receivers, and then to the buffer, as
+     * many as fit.
+     * @param data
+     * @param count - in elements.
+     * @param wake - called for every receiver that got elements, after it was
+     * removed from the queue.
+     * @return the number of elements that were passed.
+     */
+    size_t send(const char *data, size_t count, void (*wake)(WaitNode *));
+
+    /**
+     * Takes elements from the buffer, and then directly from the waiting
+     * senders. The buffer is then filled up with the rest of what they send.
+     * @param data
+     * @param count - in elements.
+     * @param wake - called for every sender whose elements were all taken,
+     * after it was removed from the queue.
+     * @return the number of elements that were taken.
+     */
+    size_t receive(char *data, size_t count, void (*wake)(WaitNode *));
+
+    /**
+     * Closes the channel: nothing can be sent anymore, and the elements in
+     * the buffer can still be received.
+     * @param wake - called for every waiting thread, after it was removed from
+     * the queue.
+     */
+    void close(void (*wake)(WaitNode *));
+
+    /**
+     * @return true if the channel was closed.
+     */
+    bool isClosed();
+
+    /**
+     * @return true if threads wait in the channel.
+     */
+    bool hasWaiters();
+
+    /**
+     * @return the size of an element, in bytes.
+     */
+    size_t getElemSize();
+
+    /**
+     * @return the queue of the senders that wait while the buffer is full.
+     */
+    uthread_wait_queue_t* getSenders();
+
+    /**
+     * @return the queue of the receivers that wait while the buffer is empty.
+     */
+    uthread_wait_queue_t* getReceivers();
+
+private:
+    char *_buffer;
+    size_t _elemSize, _capacity;
+    // the first element, and the number of elements:
+    size_t _head, _size;
+    bool _closed;
+    uthread_wait_queue_t _senders, _receivers;
+
+    /**
+     * Copies elements to the end of the buffer, as many as fit.
+     * @return the number of elements that were copied.
+     */
+    size_t push(const char *data, size_t count);
+
+    /**
+     * Copies elements from the front of the buffer, as many as there are.
+     * @return the number of elements that were copied.
+     */
+    size_t pop(char *data, size_t count);
+};
+
+#endif //EX2_CHANNEL_H
@@ -0,0 +1,114 @@
+/**
+ * @file IdAllocator.cpp
+ * @brief Allocates the smallest available thread ID in O(1).
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include "IdAllocator.h"
+
+#define WORD_BITS 64
+#define WORD_SHIFT 6
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @brief Constructor with the number of IDs. All IDs are free.
+ * @param capacity - IDs are in the range [0, capacity).
+ */
+IdAllocator::IdAllocator(int capacity) :
+        _chunks((capacity + (1 << ID_CHUNK_SHIFT) - 1) >> ID_CHUNK_SHIFT),
+        _capacity(capacity)
+{
+    int bits = (capacity + WORD_BITS - 1) >> WORD_SHIFT;
+    while (bits > 1) {
+        int words = (bits + WORD_BITS - 1) >> WORD_SHIFT;
+        std::vector<uint64_t> level(words, ~(uint64_t)0);
+        // bits past the end of the level are never free:
+        if (bits % WORD_BITS) {
+            level[words - 1] = ((uint64_t)1 << (bits % WORD_BITS)) - 1;
+        }
+        _levels.push_back(level);
+        bits = words;
+    }
+}
+
+/**
+ * Finds a word of the bits of the IDs, and allocates its chunk if it was not
+ * used yet - with all of its IDs free.
+ * @param word - the index of the word.
+ * @return the word.
+ */
+uint64_t& IdAllocator::idWord(int word)
+{
+    std::unique_ptr<uint64_t[]> &chunk = _chunks[word / ID_CHUNK_WORDS];
+    if (!chunk) {
+        chunk.reset(new uint64_t[ID_CHUNK_WORDS]);
+        int first = word / ID_CHUNK_WORDS * ID_CHUNK_WORDS;
+        for (int i = 0; i < ID_CHUNK_WORDS; i++) {
+            // bits past the capacity are never free:
+            int free = _capacity - (first + i) * WORD_BITS;
+            chunk[i] = free >= WORD_BITS ? ~(uint64_t)0 :
+                       free > 0 ? ((uint64_t)1 << free) - 1 : 0;
+        }
+    }
+    return chunk[word % ID_CHUNK_WORDS];
+}
+
+/**
+ * Allocates the smallest free ID.
+ * @return the ID, or -1 if all IDs are in use.
+ */
+int IdAllocator::allocate()
+{
+    if (_capacity <= 0 || (_levels.empty() ? !idWord(0) : !_levels.back()[0])) {
+        return -1;
+    }
+    // walk down to the first free ID:
+    int idx = 0;
+    for (int level = (int)_levels.size() - 1; level >= 0; level--) {
+        idx = (idx << WORD_SHIFT) + __builtin_ctzll(_levels[level][idx]);
+    }
+    uint64_t &word = idWord(idx);
+    idx = (idx << WORD_SHIFT) + __builtin_ctzll(word);
+    // mark it used, and clear summary bits of words that became full:
+    int id = idx;
+    word &= ~((uint64_t)1 << (idx % WORD_BITS));
+    if (word) {
+        return id;
+    }
+    idx >>= WORD_SHIFT;
+    for (auto &level: _levels) {
+        uint64_t &summary = level[idx >> WORD_SHIFT];
+        summary &= ~((uint64_t)1 << (idx % WORD_BITS));
+        if (summary) {
+            break;
+        }
+        idx >>= WORD_SHIFT;
+    }
+    return id;
+}
+
+/**
+ * Returns an allocated ID to the allocator.
+ * @param id
+ */
+void IdAllocator::release(int id)
+{
+    uint64_t &word = idWord(id >> WORD_SHIFT);
+    bool wasFull = !word;
+    word |= (uint64_t)1 << (id % WORD_BITS);
+    if (!wasFull) {
+        return;
+    }
+    int idx = id >> WORD_SHIFT;
+    for (auto &level: _levels) {
+        uint64_t &summary = level[idx >> WORD_SHIFT];
+        wasFull = !summary;
+        summary |= (uint64_t)1 << (idx % WORD_BITS);
+        if (!wasFull) {
+            break;
+        }
+        idx >>= WORD_SHIFT;
+    }
+}
@@ -0,0 +1,61 @@
+/**
+ * @file IdAllocator.h
+ * @brief Allocates the smallest available thread ID in O(1).
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_IDALLOCATOR_H
+#define EX2_IDALLOCATOR_H
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+#define ID_CHUNK_SHIFT 12
+#define ID_CHUNK_WORDS ((1 << ID_CHUNK_SHIFT) / 64)
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A hierarchical bitmap of free IDs. Each bit of a level summarizes a word of
+ * the level below it (set - the word has a free ID), so finding the smallest
+ * free ID is a find-first-set per level, from the single top word down. The
+ * bits of the IDs themselves are allocated in chunks as IDs are first used,
+ * like the slots of the ThreadTable, so a large limit costs only the
+ * summaries - a 64th of it - until it is reached.
+ */
+class IdAllocator
+{
+public:
+    /**
+     * @brief Constructor with the number of IDs. All IDs are free.
+     * @param capacity - IDs are in the range [0, capacity).
+     */
+    explicit IdAllocator(int capacity);
+
+    /**
+     * Allocates the smallest free ID.
+     * @return the ID, or -1 if all IDs are in use.
+     */
+    int allocate();
+
+    /**
+     * Returns an allocated ID to the allocator.
+     * @param id
+     */
+    void release(int id);
+
+private:
+    uint64_t& idWord(int word);
+
+    // a bit per ID, in chunks of ID_CHUNK_WORDS words - nullptr until one of
+    // its IDs is allocated:
+    std::vector<std::unique_ptr<uint64_t[]>> _chunks;
+    int _capacity;
+    // the summaries of the words below, from the words of IDs up. the last
+    // level holds a single word, and there is none if the IDs fit in one:
+    std::vector<std::vector<uint64_t>> _levels;
+};
+
+#endif //EX2_IDALLOCATOR_H
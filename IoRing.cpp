@@ -0,0 +1,206 @@
+/**
+ * @file IoRing.cpp
+ * @brief Asynchronous file I/O of threads, through io_uring.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "IoRing.h"
+
+// the largest transfer of a single read() or write():
+#define MAX_IO_COUNT 0x7ffff000
+
+// ------------------------------- methods ------------------------------
+
+IoRing::IoRing() : _ringFd(-1), _state(0), _size(0), _unsubmitted(0),
+                   _sqRing(MAP_FAILED), _cqRing(MAP_FAILED),
+                   _sqRingSize(0), _cqRingSize(0),
+                   _sqes((struct io_uring_sqe *)MAP_FAILED)
+{
+}
+
+/**
+ * @brief Destructor. Unmaps the queues and closes the ring.
+ */
+IoRing::~IoRing()
+{
+    if (_sqes != MAP_FAILED) {
+        munmap(_sqes, _sqEntries * sizeof(struct io_uring_sqe));
+    }
+    if (_cqRing != MAP_FAILED && _cqRing != _sqRing) {
+        munmap(_cqRing, _cqRingSize);
+    }
+    if (_sqRing != MAP_FAILED) {
+        munmap(_sqRing, _sqRingSize);
+    }
+    if (_ringFd != -1) {
+        close(_ringFd);
+    }
+}
+
+/**
+ * Creates the ring and maps its queues.
+ * @return 0 on success, -1 on failure.
+ */
+int IoRing::setup()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    _ringFd = (int)syscall(__NR_io_uring_setup, IO_RING_ENTRIES, &params);
+    if (_ringFd == -1) {
+        return -1;
+    }
+    // IORING_OP_READ and IORING_OP_WRITE came with this feature, and without
+    // IORING_FEAT_NODROP a burst of completions could be lost:
+    if (!(params.features & IORING_FEAT_RW_CUR_POS) ||
+        !(params.features & IORING_FEAT_NODROP)) {
+        return -1;
+    }
+    _sqEntries = params.sq_entries;
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingSize = params.cq_off.cqes +
+                  params.cq_entries * sizeof(struct io_uring_cqe);
+    // both rings may share a single mapping:
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) {
+        _sqRingSize = _cqRingSize = std::max(_sqRingSize, _cqRingSize);
+    }
+    _sqRing = mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING);
+    if (_sqRing == MAP_FAILED) {
+        return -1;
+    }
+    _cqRing = singleMap ? _sqRing :
+              mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING);
+    if (_cqRing == MAP_FAILED) {
+        return -1;
+    }
+    _sqes = (struct io_uring_sqe *)mmap(
+            nullptr, _sqEntries * sizeof(struct io_uring_sqe),
+            PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd,
+            IORING_OFF_SQES);
+    if (_sqes == MAP_FAILED) {
+        return -1;
+    }
+    char *sq = (char *)_sqRing, *cq = (char *)_cqRing;
+    _sqHead = (unsigned *)(sq + params.sq_off.head);
+    _sqTail = (unsigned *)(sq + params.sq_off.tail);
+    _sqMask = (unsigned *)(sq + params.sq_off.ring_mask);
+    _sqArray = (unsigned *)(sq + params.sq_off.array);
+    _cqHead = (unsigned *)(cq + params.cq_off.head);
+    _cqTail = (unsigned *)(cq + params.cq_off.tail);
+    _cqMask = (unsigned *)(cq + params.cq_off.ring_mask);
+    _cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+}
+
+/**
+ * Sets up the ring on the first call.
+ * @return true if the ring can be used. It can not if the kernel does not
+ * support io_uring, or it is not allowed.
+ */
+bool IoRing::available()
+{
+    if (!_state) {
+        _state = setup() ? -1 : 1;
+    }
+    return _state == 1;
+}
+
+/**
+ * Queues a read or a write of a thread. If the submission queue is full,
+ * it is submitted (and completions are reaped, until it is not full).
+ * @param opcode - IORING_OP_READ / IORING_OP_WRITE.
+ * @param fd
+ * @param data - the buffer, which must stay valid until the completion.
+ * @param count
+ * @param offset
+ * @param thread
+ * @param complete - called for every reaped completion, with the thread
+ * and the result of its request (-errno on failure).
+ */
+void IoRing::queue(int opcode, int fd, void *data, size_t count, off_t offset,
+                   Thread *thread, void (*complete)(Thread *, int))
+{
+    unsigned tail = *_sqTail;
+    while (tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) == _sqEntries) {
+        submit();
+        reap(complete);
+    }
+    unsigned index = tail & *_sqMask;
+    struct io_uring_sqe *sqe = &_sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = (__u8)opcode;
+    sqe->fd = fd;
+    sqe->addr = (__u64)(unsigned long)data;
+    sqe->len = (__u32)std::min(count, (size_t)MAX_IO_COUNT);
+    sqe->off = (__u64)offset;
+    sqe->user_data = (__u64)(unsigned long)thread;
+    _sqArray[index] = index;
+    // the kernel may read the entry as soon as it sees the new tail:
+    __atomic_store_n(_sqTail, tail + 1, __ATOMIC_RELEASE);
+    _unsubmitted++;
+    _size++;
+}
+
+/**
+ * Hands all the queued requests to the kernel.
+ */
+void IoRing::submit()
+{
+    if (!_unsubmitted) {
+        return;
+    }
+    // on failure (the kernel is out of memory, or the completion queue
+    // overflowed) the requests stay queued, and are submitted next time:
+    long submitted = syscall(__NR_io_uring_enter, _ringFd, _unsubmitted, 0, 0,
+                             nullptr, 0);
+    if (submitted > 0) {
+        _unsubmitted -= (int)submitted;
+    }
+}
+
+/**
+ * Calls complete for every completed request.
+ * @param complete - called with the thread and the result of its request
+ * (-errno on failure).
+ * @return the number of completed requests.
+ */
+int IoRing::reap(void (*complete)(Thread *, int))
+{
+    unsigned head = *_cqHead;
+    unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+    int reaped = 0;
+    for (; head != tail; head++, reaped++) {
+        struct io_uring_cqe *cqe = &_cqes[head & *_cqMask];
+        complete((Thread *)(unsigned long)cqe->user_data, cqe->res);
+    }
+    // the entries can be reused by the kernel once the new head is seen:
+    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+    _size -= reaped;
+    return reaped;
+}
+
+/**
+ * @return the number of requests that were queued and not reaped yet.
+ */
+int IoRing::size()
+{
+    return _size;
+}
+
+/**
+ * @return the ring's file descriptor. It is readable while there are
+ * completions to reap.
+ */
+int IoRing::fd()
+{
+    return _ringFd;
+}
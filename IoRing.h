@@ -0,0 +1,104 @@
+/**
+ * @file IoRing.h
+ * @brief Asynchronous file I/O of threads, through io_uring.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_IORING_H
+#define EX2_IORING_H
+#include <sys/types.h>
+
+// number of submission queue entries:
+#define IO_RING_ENTRIES 256
+
+class Thread;
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * An io_uring instance, driven through the raw system calls. Requests are
+ * only written to the shared submission queue when they are queued, and the
+ * queue is handed to the kernel by submit(), with a single io_uring_enter for
+ * all the requests queued since the last one. Completions are read from the
+ * shared completion queue by reap(), without a system call. Every request
+ * carries the thread that queued it.
+ */
+class IoRing
+{
+public:
+    IoRing();
+
+    /**
+     * @brief Destructor. Unmaps the queues and closes the ring.
+     */
+    ~IoRing();
+
+    /**
+     * Sets up the ring on the first call.
+     * @return true if the ring can be used. It can not if the kernel does not
+     * support io_uring, or it is not allowed.
+     */
+    bool available();
+
+    /**
+     * Queues a read or a write of a thread. If the submission queue is full,
+     * it is submitted (and completions are reaped, until it is not full).
+     * @param opcode - IORING_OP_READ / IORING_OP_WRITE.
+     * @param fd
+     * @param data - the buffer, which must stay valid until the completion.
+     * @param count
+     * @param offset
+     * @param thread
+     * @param complete - called for every reaped completion, with the thread
+     * and the result of its request (-errno on failure).
+     */
+    void queue(int opcode, int fd, void *data, size_t count, off_t offset,
+               Thread *thread, void (*complete)(Thread *, int));
+
+    /**
+     * Hands all the queued requests to the kernel.
+     */
+    void submit();
+
+    /**
+     * Calls complete for every completed request.
+     * @param complete - called with the thread and the result of its request
+     * (-errno on failure).
+     * @return the number of completed requests.
+     */
+    int reap(void (*complete)(Thread *, int));
+
+    /**
+     * @return the number of requests that were queued and not reaped yet.
+     */
+    int size();
+
+    /**
+     * @return the ring's file descriptor. It is readable while there are
+     * completions to reap.
+     */
+    int fd();
+
+private:
+    int _ringFd;
+    // -1 - setting up failed, 0 - not set up yet, 1 - set up:
+    int _state;
+    int _size, _unsubmitted;
+    void *_sqRing, *_cqRing;
+    size_t _sqRingSize, _cqRingSize;
+    struct io_uring_sqe *_sqes;
+    unsigned _sqEntries;
+    unsigned *_sqHead, *_sqTail, *_sqMask, *_sqArray;
+    unsigned *_cqHead, *_cqTail, *_cqMask;
+    struct io_uring_cqe *_cqes;
+
+    /**
+     * Creates the ring and maps its queues.
+     * @return 0 on success, -1 on failure.
+     */
+    int setup();
+};
+
+#endif //EX2_IORING_H
@@ -0,0 +1,241 @@
+/**
+ * @file Reactor.cpp
+ * @brief Parks threads on file descriptors until they are ready.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <climits>
+#include <algorithm>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include "Reactor.h"
+
+// the most events handled by a single poll():
+#define MAX_EVENTS 64
+
+// ------------------------------- methods ------------------------------
+
+Reactor::Reactor() : _epollFd(-1), _size(0)
+{
+}
+
+/**
+ * @brief Destructor. Closes the epoll instance.
+ */
+Reactor::~Reactor()
+{
+    if (_epollFd != -1) {
+        close(_epollFd);
+    }
+}
+
+/**
+ * @return the state of fd, growing the table to hold it. Growing it does not
+ * move the states, which the nodes in their queues point to.
+ */
+Reactor::FdState& Reactor::state(int fd)
+{
+    if (fd >= (int)_fds.size()) {
+        _fds.resize(fd + 1);
+    }
+    return _fds[fd];
+}
+
+/**
+ * Creates the epoll instance on the first call.
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+int Reactor::open()
+{
+    if (_epollFd == -1) {
+        _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    }
+    return _epollFd == -1 ? -1 : 0;
+}
+
+/**
+ * Puts a file descriptor in non-blocking mode, once.
+ * @param fd
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+int Reactor::prepare(int fd)
+{
+    if (fd < 0) {
+        errno = EBADF;
+        return -1;
+    }
+    FdState &fdState = state(fd);
+    if (fdState.prepared) {
+        return 0;
+    }
+    int flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || (!(flags & O_NONBLOCK) &&
+                        fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)) {
+        return -1;
+    }
+    fdState.prepared = true;
+    return 0;
+}
+
+/**
+ * Parks a thread on a file descriptor, until it is ready for the
+ * direction.
+ * @param node - a wait node of the thread, which is not queued.
+ * @param fd
+ * @param direction - REACTOR_READ / REACTOR_WRITE.
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+int Reactor::wait(WaitNode *node, int fd, int direction)
+{
+    if (open()) {
+        return -1;
+    }
+    FdState &fdState = state(fd);
+    if (!fdState.registered) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = fd;
+        if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            return -1;
+        }
+        fdState.registered = true;
+    }
+    WaitQueue(&fdState.waiters[direction]).pushBack(node);
+    node->fd = fd;
+    _size++;
+    return 0;
+}
+
+/**
+ * Adds a file descriptor that wakes up poll() when it is readable, but has
+ * no threads parked on it. Does nothing if it was already added.
+ * @param fd
+ * @return 0 on success, -1 on failure (errno is set).
+ */
+int Reactor::watch(int fd)
+{
+    if (open()) {
+        return -1;
+    }
+    FdState &fdState = state(fd);
+    if (!fdState.registered) {
+        struct epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+            return -1;
+        }
+        fdState.registered = true;
+    }
+    return 0;
+}
+
+/**
+ * Removes a parked thread before its file descriptor is ready.
+ * @param node - the node it was parked with.
+ */
+void Reactor::cancel(WaitNode *node)
+{
+    WaitQueue(node->queue).remove(node);
+    node->fd = -1;
+    _size--;
+}
+
+/**
+ * Wakes up the threads parked on the file descriptors that became ready.
+ * @param timeoutUsec - how long to wait for a file descriptor to become
+ * ready, in micro-seconds (-1 - forever, 0 - return right away).
+ * @param wake - called with the node of every woken up thread, after it is
+ * removed.
+ * @return the number of threads woken up.
+ */
+int Reactor::poll(long long timeoutUsec, void (*wake)(WaitNode *))
+{
+    struct epoll_event events[MAX_EVENTS];
+    if (open()) {
+        return 0;
+    }
+    int numEvents = -1;
+#ifdef SYS_epoll_pwait2
+    // epoll_pwait2 takes the timeout in nano-seconds:
+    if (timeoutUsec > 0) {
+        struct timespec timeout;
+        timeout.tv_sec = (time_t)(timeoutUsec / 1000000);
+        timeout.tv_nsec = (long)(timeoutUsec % 1000000) * 1000;
+        numEvents = (int)syscall(SYS_epoll_pwait2, _epollFd, events, MAX_EVENTS,
+                                 &timeout, nullptr, 0);
+    }
+#endif
+    // epoll_wait takes it in milli-seconds, rounded up so it does not return
+    // early:
+    if (timeoutUsec <= 0 || (numEvents == -1 && errno == ENOSYS)) {
+        int timeoutMs = timeoutUsec < 0 ? -1 :
+                        (int)std::min((timeoutUsec + 999) / 1000,
+                                      (long long)INT_MAX);
+        numEvents = epoll_wait(_epollFd, events, MAX_EVENTS, timeoutMs);
+    }
+    int woken = 0;
+    for (int i = 0; i < numEvents; i++) {
+        FdState &fdState = _fds[events[i].data.fd];
+        // an error or a hang up wakes up both directions - the operation they
+        // retry reports it:
+        bool ready[2];
+        ready[REACTOR_READ] = events[i].events &
+                (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR);
+        ready[REACTOR_WRITE] = events[i].events &
+                (EPOLLOUT | EPOLLHUP | EPOLLERR);
+        for (int direction = 0; direction < 2; direction++) {
+            WaitNode *node;
+            while (ready[direction] &&
+                   (node = WaitQueue(&fdState.waiters[direction]).popFront())) {
+                node->fd = -1;
+                _size--;
+                woken++;
+                wake(node);
+            }
+        }
+    }
+    return woken;
+}
+
+/**
+ * Forgets a file descriptor that is about to be closed, so that a new one
+ * with the same number is set up again. Threads parked on it are woken
+ * up, and find it closed when they retry.
+ * @param fd
+ * @param wake - called with the node of every woken up thread, after it is
+ * removed.
+ */
+void Reactor::forget(int fd, void (*wake)(WaitNode *))
+{
+    if (fd < 0 || fd >= (int)_fds.size()) {
+        return;
+    }
+    // closing the file descriptor removes it from the epoll instance, unless
+    // it was duplicated - then it is still there, and would keep reporting
+    // events for a new file descriptor with the same number:
+    if (_fds[fd].registered) {
+        epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    _fds[fd].prepared = _fds[fd].registered = false;
+    for (int direction = 0; direction < 2; direction++) {
+        WaitNode *node;
+        while ((node = WaitQueue(&_fds[fd].waiters[direction]).popFront())) {
+            node->fd = -1;
+            _size--;
+            wake(node);
+        }
+    }
+}
+
+/**
+ * @return the number of parked threads.
+ */
+int Reactor::size()
+{
+    return _size;
+}
@@ -0,0 +1,119 @@
+/**
+ * @file Reactor.h
+ * @brief Parks threads on file descriptors until they are ready.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_REACTOR_H
+#define EX2_REACTOR_H
+#include <deque>
+#include "WaitQueue.h"
+
+// the directions a thread can wait on a file descriptor for:
+#define REACTOR_READ 0
+#define REACTOR_WRITE 1
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * The threads waiting for file descriptors, by their wait nodes, and an epoll
+ * instance that reports which of them are ready. Every file descriptor is registered once,
+ * edge-triggered, for both directions, so parking a thread on it again costs
+ * no system call. Since an edge is only reported once, a thread must retry its
+ * operation before it parks - a thread that is woken up may find that another
+ * one got to the data first, and simply parks again.
+ */
+class Reactor
+{
+public:
+    Reactor();
+
+    /**
+     * @brief Destructor. Closes the epoll instance.
+     */
+    ~Reactor();
+
+    /**
+     * Puts a file descriptor in non-blocking mode, once.
+     * @param fd
+     * @return 0 on success, -1 on failure (errno is set).
+     */
+    int prepare(int fd);
+
+    /**
+     * Parks a thread on a file descriptor, until it is ready for the
+     * direction.
+     * @param node - a wait node of the thread, which is not queued.
+     * @param fd
+     * @param direction - REACTOR_READ / REACTOR_WRITE.
+     * @return 0 on success, -1 on failure (errno is set).
+     */
+    int wait(WaitNode *node, int fd, int direction);
+
+    /**
+     * Adds a file descriptor that wakes up poll() when it is readable, but has
+     * no threads parked on it. Does nothing if it was already added.
+     * @param fd
+     * @return 0 on success, -1 on failure (errno is set).
+     */
+    int watch(int fd);
+
+    /**
+     * Removes a parked thread before its file descriptor is ready.
+     * @param node - the node it was parked with.
+     */
+    void cancel(WaitNode *node);
+
+    /**
+     * Wakes up the threads parked on the file descriptors that became ready.
+     * @param timeoutUsec - how long to wait for a file descriptor to become
+     * ready, in micro-seconds (-1 - forever, 0 - return right away).
+     * @param wake - called with the node of every woken up thread, after it
+     * is removed.
+     * @return the number of threads woken up.
+     */
+    int poll(long long timeoutUsec, void (*wake)(WaitNode *));
+
+    /**
+     * Forgets a file descriptor that is about to be closed, so that a new one
+     * with the same number is set up again. Threads parked on it are woken
+     * up, and find it closed when they retry.
+     * @param fd
+     * @param wake - called with the node of every woken up thread, after it
+     * is removed.
+     */
+    void forget(int fd, void (*wake)(WaitNode *));
+
+    /**
+     * @return the number of parked threads.
+     */
+    int size();
+
+private:
+    struct FdState
+    {
+        uthread_wait_queue_t waiters[2];
+        bool prepared, registered;
+        FdState(): waiters(), prepared(false), registered(false) {}
+    };
+
+    /**
+     * @return the state of fd, growing the table to hold it. Growing it does
+     * not move the states, which the nodes in their queues point to.
+     */
+    FdState& state(int fd);
+
+    /**
+     * Creates the epoll instance on the first call.
+     * @return 0 on success, -1 on failure (errno is set).
+     */
+    int open();
+
+    int _epollFd;
+    int _size;
+    std::deque<FdState> _fds;
+};
+
+#endif //EX2_REACTOR_H
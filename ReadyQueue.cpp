@@ -0,0 +1,104 @@
+/**
+ * @file ReadyQueue.cpp
+ * @brief The READY threads, by priority level.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include "ReadyQueue.h"
+#include "Thread.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @brief Constructor with the table the threads' priorities are in.
+ * @param table
+ */
+ReadyQueue::ReadyQueue(const ThreadTable &table) :
+        _table(table), _nonEmpty(0), _boostEpoch(0)
+{
+}
+
+/**
+ * Appends a thread to the end of its level. A thread that was not
+ * queued since the last boost() is first moved back to its priority.
+ * @param thread
+ */
+void ReadyQueue::pushBack(Thread *thread)
+{
+    if (thread->getBoostEpoch() != _boostEpoch) {
+        thread->setBoostEpoch(_boostEpoch);
+        thread->setLevel(_table.getPriority(thread->getId()));
+    }
+    int level = thread->getLevel();
+    _levels[level].pushBack(thread);
+    _nonEmpty |= 1u << level;
+}
+
+/**
+ * Removes the first thread of the highest non-empty level.
+ * @return the removed thread, or nullptr if the queue is empty.
+ */
+Thread* ReadyQueue::popFront()
+{
+    if (!_nonEmpty) {
+        return nullptr;
+    }
+    int level = __builtin_ctz(_nonEmpty);
+    Thread *thread = _levels[level].popFront();
+    if (_levels[level].empty()) {
+        _nonEmpty &= ~(1u << level);
+    }
+    return thread;
+}
+
+/**
+ * Removes a thread of the queue.
+ * @param thread - a thread that is in the queue.
+ */
+void ReadyQueue::remove(Thread *thread)
+{
+    int level = thread->getLevel();
+    _levels[level].remove(thread);
+    if (_levels[level].empty()) {
+        _nonEmpty &= ~(1u << level);
+    }
+}
+
+/**
+ * Moves every thread back to the level of its priority: threads in the
+ * queue right away, the others when they are next queued.
+ */
+void ReadyQueue::boost()
+{
+    _boostEpoch++;
+    for (int level = 1; level < UTHREAD_NUM_PRIORITIES; level++) {
+        // threads whose priority is this level are queued again behind the
+        // others, so each thread is moved exactly once:
+        for (int i = _levels[level].size(); i > 0; i--) {
+            pushBack(_levels[level].popFront());
+        }
+        if (_levels[level].empty()) {
+            _nonEmpty &= ~(1u << level);
+        }
+    }
+}
+
+/**
+ * Removes all threads from the queue.
+ */
+void ReadyQueue::clear()
+{
+    for (auto &level: _levels) {
+        level.clear();
+    }
+    _nonEmpty = 0;
+}
+
+/**
+ * @return true if the queue is empty.
+ */
+bool ReadyQueue::empty()
+{
+    return _nonEmpty == 0;
+}
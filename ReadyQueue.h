@@ -0,0 +1,75 @@
+/**
+ * @file ReadyQueue.h
+ * @brief The READY threads, by priority level.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_READYQUEUE_H
+#define EX2_READYQUEUE_H
+#include "ThreadList.h"
+#include "ThreadTable.h"
+#include "uthreads.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A FIFO list of READY threads per priority level, 0 being the highest.
+ * Threads are queued at their current level (Thread::getLevel()), and the
+ * front thread is taken from the highest non-empty level, found with a
+ * find-first-set over a bitmap of the non-empty levels.
+ */
+class ReadyQueue
+{
+public:
+    /**
+     * @brief Constructor with the table the threads' priorities are in.
+     * @param table
+     */
+    explicit ReadyQueue(const ThreadTable &table);
+
+    /**
+     * Appends a thread to the end of its level. A thread that was not
+     * queued since the last boost() is first moved back to its priority.
+     * @param thread
+     */
+    void pushBack(Thread *thread);
+
+    /**
+     * Removes the first thread of the highest non-empty level.
+     * @return the removed thread, or nullptr if the queue is empty.
+     */
+    Thread* popFront();
+
+    /**
+     * Removes a thread of the queue.
+     * @param thread - a thread that is in the queue.
+     */
+    void remove(Thread *thread);
+
+    /**
+     * Moves every thread back to the level of its priority: threads in the
+     * queue right away, the others when they are next queued.
+     */
+    void boost();
+
+    /**
+     * Removes all threads from the queue.
+     */
+    void clear();
+
+    /**
+     * @return true if the queue is empty.
+     */
+    bool empty();
+
+private:
+    const ThreadTable &_table;
+    ThreadList _levels[UTHREAD_NUM_PRIORITIES];
+    // bit i is set if level i is not empty:
+    unsigned int _nonEmpty;
+    unsigned int _boostEpoch;
+};
+
+#endif //EX2_READYQUEUE_H
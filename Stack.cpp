@@ -0,0 +1,80 @@
+/**
+ * @file Stack.cpp
+ * @brief A thread stack, guarded against overflows.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include <sys/mman.h>
+#include <unistd.h>
+#include "Stack.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @brief Constructs an empty stack. Nothing is mapped.
+ */
+Stack::Stack() : _mapping(nullptr), _mappingSize(0)
+{
+}
+
+/**
+ * Maps the stack.
+ * @param size - usable size in bytes, rounded up to whole pages.
+ * @return 0 on success, -1 on failure.
+ */
+int Stack::allocate(size_t size)
+{
+    size_t pageSize = Stack::pageSize();
+    size_t mappingSize = ((size + pageSize - 1) / pageSize + 1) * pageSize;
+    void *mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return -1;
+    }
+    // the stack grows down, so the guard page is the lowest one:
+    if (mprotect(mapping, pageSize, PROT_NONE)) {
+        munmap(mapping, mappingSize);
+        return -1;
+    }
+    _mapping = (char*)mapping;
+    _mappingSize = mappingSize;
+    return 0;
+}
+
+/**
+ * Unmaps the stack, if it is mapped.
+ */
+void Stack::release()
+{
+    if (_mapping) {
+        munmap(_mapping, _mappingSize);
+        _mapping = nullptr;
+        _mappingSize = 0;
+    }
+}
+
+/**
+ * @return the address the stack grows down from.
+ */
+char* Stack::top()
+{
+    return _mapping + _mappingSize;
+}
+
+/**
+ * @return the usable size of the stack in bytes.
+ */
+size_t Stack::size()
+{
+    return _mappingSize ? _mappingSize - pageSize() : 0;
+}
+
+/**
+ * @return the size of a page in bytes, looked up once.
+ */
+size_t Stack::pageSize()
+{
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    return pageSize;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file Stack.h
+ * @brief A thread stack, guarded against overflows.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_STACK_H
+#define EX2_STACK_H
+#include <cstddef>
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A stack mapped separately from the thread that runs on it, with an
+ * inaccessible guard page below its lowest address, so that an overflow
+ * faults instead of overwriting whatever is mapped next to it.
+ */
+class Stack
+{
+public:
+    /**
+     * @brief Constructs an empty stack. Nothing is mapped.
+     */
+    Stack();
+
+    /**
+     * Maps the stack.
+     * @param size - usable size in bytes, rounded up to whole pages.
+     * @return 0 on success, -1 on failure.
+     */
+    int allocate(size_t size);
+
+    /**
+     * Unmaps the stack, if it is mapped.
+     */
+    void release();
+
+    /**
+     * @return the address the stack grows down from.
+     */
+    char* top();
+
+    /**
+     * @return the usable size of the stack in bytes.
+     */
+    size_t size();
+
+    /**
+     * @return the size of a page in bytes, looked up once.
+     */
+    static size_t pageSize();
+
+private:
+    char *_mapping;
+    size_t _mappingSize;
+};
+
+#endif //EX2_STACK_H
@@ -0,0 +1,122 @@
+/**
+ * @file TaskPool.cpp
+ * @brief The tasks of the worker pool, and the futures of their results.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include "TaskPool.h"
+
+// ------------------------------- methods ------------------------------
+
+TaskPool::TaskPool() : _head(nullptr), _tail(nullptr), _free(nullptr),
+                       _idleWorkers(), _stopping(false)
+{
+}
+
+/**
+ * @brief Destructor. Frees the free futures.
+ */
+TaskPool::~TaskPool()
+{
+    while (_free) {
+        Future *next = _free->next;
+        delete _free;
+        _free = next;
+    }
+}
+
+/**
+ * @return a future for a new task, taken from the free list if it is not
+ * empty.
+ * @param fn
+ * @param arg
+ */
+Future* TaskPool::acquire(void *(*fn)(void *), void *arg)
+{
+    Future *future = _free;
+    if (future) {
+        _free = future->next;
+    } else {
+        future = new Future();
+    }
+    future->next = nullptr;
+    future->fn = fn;
+    future->arg = arg;
+    future->result = nullptr;
+    future->done = false;
+    future->waiters.head = future->waiters.tail = nullptr;
+    return future;
+}
+
+/**
+ * Puts a future whose result was taken on the free list.
+ * @param future
+ */
+void TaskPool::release(Future *future)
+{
+    future->next = _free;
+    _free = future;
+}
+
+/**
+ * Appends a task to the end of the queue.
+ * @param task
+ */
+void TaskPool::push(Future *task)
+{
+    task->next = nullptr;
+    if (_tail) {
+        _tail->next = task;
+    } else {
+        _head = task;
+    }
+    _tail = task;
+}
+
+/**
+ * Removes the first task of the queue.
+ * @return the task, or nullptr if the queue is empty.
+ */
+Future* TaskPool::pop()
+{
+    Future *task = _head;
+    if (task) {
+        _head = task->next;
+        if (!_head) {
+            _tail = nullptr;
+        }
+        task->next = nullptr;
+    }
+    return task;
+}
+
+/**
+ * @return the queue of the workers that wait for a task.
+ */
+uthread_wait_queue_t* TaskPool::getIdleWorkers()
+{
+    return &_idleWorkers;
+}
+
+/**
+ * @return the IDs of the workers.
+ */
+std::vector<int>& TaskPool::getWorkers()
+{
+    return _workers;
+}
+
+/**
+ * Set whether the workers should terminate once the queue is empty.
+ * @param flag
+ */
+void TaskPool::setStopping(bool flag)
+{
+    _stopping = flag;
+}
+
+bool TaskPool::isStopping()
+{
+    return _stopping;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file TaskPool.h
+ * @brief The tasks of the worker pool, and the futures of their results.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_TASKPOOL_H
+#define EX2_TASKPOOL_H
+#include <vector>
+#include "uthreads.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A submitted task, which is also the future of its result.
+ */
+struct Future
+{
+    // the next task in the queue, or the next free future:
+    Future *next;
+    void *(*fn)(void *);
+    void *arg;
+    void *result;
+    bool done;
+    // the thread that waits for the result:
+    uthread_wait_queue_t waiters;
+};
+
+/**
+ * The queue of tasks that wait for a worker, the workers that wait for a
+ * task, and a free list of futures - a future is reused once its result was
+ * taken, so submitting a task allocates nothing in the steady state.
+ */
+class TaskPool
+{
+public:
+    TaskPool();
+
+    /**
+     * @brief Destructor. Frees the free futures.
+     */
+    ~TaskPool();
+
+    /**
+     * @return a future for a new task, taken from the free list if it is not
+     * empty.
+     * @param fn
+     * @param arg
+     */
+    Future* acquire(void *(*fn)(void *), void *arg);
+
+    /**
+     * Puts a future whose result was taken on the free list.
+     * @param future
+     */
+    void release(Future *future);
+
+    /**
+     * Appends a task to the end of the queue.
+     * @param task
+     */
+    void push(Future *task);
+
+    /**
+     * Removes the first task of the queue.
+     * @return the task, or nullptr if the queue is empty.
+     */
+    Future* pop();
+
+    /**
+     * @return the queue of the workers that wait for a task.
+     */
+    uthread_wait_queue_t* getIdleWorkers();
+
+    /**
+     * @return the IDs of the workers.
+     */
+    std::vector<int>& getWorkers();
+
+    /**
+     * Set whether the workers should terminate once the queue is empty.
+     * @param flag
+     */
+    void setStopping(bool flag);
+
+    /**
+     * @return true if the workers should terminate once the queue is empty.
+     */
+    bool isStopping();
+
+private:
+    Future *_head, *_tail, *_free;
+    uthread_wait_queue_t _idleWorkers;
+    std::vector<int> _workers;
+    bool _stopping;
+};
+
+#endif //EX2_TASKPOOL_H
@@ -5,48 +5,82 @@
  */
 
 // ------------------------------ includes ------------------------------
+#include <cstring>
+#include <cstdlib>
+#include <new>
 #include "Thread.h"
 
-#define STACK_SIZE 4096
+#define MXCSR_DEFAULT 0x1f80
+#define FPUCW_DEFAULT 0x037f
 
-// from demo:
+// Context switch. Only what the calling convention requires a callee to
+// preserve is saved, so a switch is a handful of moves and no system call.
 #ifdef __x86_64__
 /* code for 64 bit Intel arch */
 
-typedef unsigned long address_t;
-#define JB_SP 6
-#define JB_PC 7
+// the stack pointer must be 16-byte aligned before a call:
+#define STACK_ALIGN 16
 
-/* A translation is required when using an address of a variable.
-   Use this as a black box in your code. */
-address_t translate_address(address_t addr)
-{
-    address_t ret;
-    asm volatile("xor    %%fs:0x30,%0\n"
-            "rol    $0x11,%0\n"
-    : "=g" (ret)
-    : "0" (addr));
-    return ret;
-}
+asm(".text\n"
+    ".globl swapContext\n"
+    ".type swapContext, @function\n"
+    "swapContext:\n"
+    // save the current context into from (%rdi):
+    "    movq %rbx, 0(%rdi)\n"
+    "    movq %rbp, 8(%rdi)\n"
+    "    movq %r12, 16(%rdi)\n"
+    "    movq %r13, 24(%rdi)\n"
+    "    movq %r14, 32(%rdi)\n"
+    "    movq %r15, 40(%rdi)\n"
+    "    leaq 8(%rsp), %rdx\n"
+    "    movq %rdx, 48(%rdi)\n"
+    "    movq (%rsp), %rdx\n"
+    "    movq %rdx, 56(%rdi)\n"
+    "    stmxcsr 64(%rdi)\n"
+    "    fnstcw 68(%rdi)\n"
+    // load the context in to (%rsi):
+    "    movq 0(%rsi), %rbx\n"
+    "    movq 8(%rsi), %rbp\n"
+    "    movq 16(%rsi), %r12\n"
+    "    movq 24(%rsi), %r13\n"
+    "    movq 32(%rsi), %r14\n"
+    "    movq 40(%rsi), %r15\n"
+    "    ldmxcsr 64(%rsi)\n"
+    "    fldcw 68(%rsi)\n"
+    "    movq 48(%rsi), %rsp\n"
+    "    jmpq *56(%rsi)\n"
+    ".size swapContext, .-swapContext\n");
 
 #else
 /* code for 32 bit Intel arch */
 
-typedef unsigned int address_t;
-#define JB_SP 4
-#define JB_PC 5
+#define STACK_ALIGN 16
 
-/* A translation is required when using an address of a variable.
-   Use this as a black box in your code. */
-address_t translate_address(address_t addr)
-{
-    address_t ret;
-    asm volatile("xor    %%gs:0x18,%0\n"
-		"rol    $0x9,%0\n"
-                 : "=g" (ret)
-                 : "0" (addr));
-    return ret;
-}
+asm(".text\n"
+    ".globl swapContext\n"
+    ".type swapContext, @function\n"
+    "swapContext:\n"
+    "    movl 4(%esp), %eax\n"
+    "    movl 8(%esp), %ecx\n"
+    // save the current context into from (%eax):
+    "    movl %ebx, 0(%eax)\n"
+    "    movl %esi, 4(%eax)\n"
+    "    movl %edi, 8(%eax)\n"
+    "    movl %ebp, 12(%eax)\n"
+    "    leal 4(%esp), %edx\n"
+    "    movl %edx, 16(%eax)\n"
+    "    movl (%esp), %edx\n"
+    "    movl %edx, 20(%eax)\n"
+    "    fnstcw 24(%eax)\n"
+    // load the context in to (%ecx):
+    "    movl 0(%ecx), %ebx\n"
+    "    movl 4(%ecx), %esi\n"
+    "    movl 8(%ecx), %edi\n"
+    "    movl 12(%ecx), %ebp\n"
+    "    fldcw 24(%ecx)\n"
+    "    movl 16(%ecx), %esp\n"
+    "    jmp *20(%ecx)\n"
+    ".size swapContext, .-swapContext\n");
 #endif
 
 // ------------------------------- methods ------------------------------
@@ -56,22 +90,93 @@ address_t translate_address(address_t addr)
 /**
  * @brief Constructor with thread ID.
  * @param tid - thread ID.
+ * @param launcher - the function the thread's context starts in.
+ * @param stack - the stack the thread runs on, owned by the thread.
+ */
+Thread::Thread(int tid, void (*launcher)(void), const Stack &stack)
+{
+    this->_stack = stack;
+    this->_entryOps = nullptr;
+    this->reset(tid, launcher);
+}
+
+/**
+ * Allocates a thread on a cache line boundary.
+ * @param size
+ * @return the memory of the thread.
+ */
+void* Thread::operator new(size_t size)
+{
+    void *ptr;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, size)) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void Thread::operator delete(void *ptr)
+{
+    free(ptr);
+}
+
+/**
+ * @brief Destructor. Destroys the entry point, and releases the thread's
+ * stack.
+ */
+Thread::~Thread()
+{
+    this->clearEntryPoint();
+    this->_stack.release();
+}
+
+/**
+ * Re-initializes a terminated thread as a new one, on the same stack.
+ * The entry point of the terminated thread was already destroyed.
+ * @param tid - thread ID.
+ * @param launcher - the function the thread's context starts in.
  */
-Thread::Thread(int tid, void (*f)(void), int stackSize)
+void Thread::reset(int tid, void (*launcher)(void))
 {
-    address_t sp, pc;
+    address_t sp;
+    this->_prev = this->_next = nullptr;
     this->_blockedNoSync = false;
-    this->_isSynced = false;
+    this->_ioPending = false;
+    this->_ioResult = 0;
+    this->_timer = TimerNode();
+    this->_timer.thread = this;
+    this->_waitNode = nullptr;
+    this->_exitWaiters.head = this->_exitWaiters.tail = nullptr;
+    memset(this->_specific, 0, sizeof(this->_specific));
+    memset(this->_specificGenerations, 0, sizeof(this->_specificGenerations));
+    this->_terminating = false;
     this->_tid = tid;
-    this->_dependencyQueue =*(new std::queue<Thread*>);
-    this->_status = READY;
     this->_numQuantums = 0;
-    sp = (address_t)this->_stack + stackSize - sizeof(address_t);
-    pc = (address_t)f;
-    sigsetjmp(this->_contextBuf, 1);
-    (this->_contextBuf->__jmpbuf)[JB_SP] = translate_address(sp);
-    (this->_contextBuf->__jmpbuf)[JB_PC] = translate_address(pc);
-    sigemptyset(&_contextBuf->__saved_mask);
+    this->_level = 0;
+    this->_boostEpoch = 0;
+    memset(&this->_contextBuf, 0, sizeof(this->_contextBuf));
+    if (!launcher) {
+        // the context is saved when the thread is first switched out.
+        return;
+    }
+    // the launcher is entered as if it was called: aligned stack, and a null
+    // return address on top of it.
+    sp = (address_t)this->_stack.top() & ~(address_t)(STACK_ALIGN - 1);
+    sp -= sizeof(address_t);
+    *(address_t*)sp = 0;
+    this->_contextBuf.sp = sp;
+    this->_contextBuf.pc = (address_t)launcher;
+#ifdef __x86_64__
+    this->_contextBuf.mxcsr = MXCSR_DEFAULT;
+#endif
+    this->_contextBuf.fpucw = FPUCW_DEFAULT;
+}
+
+/**
+ * @return the usable size of the thread's stack in bytes.
+ */
+size_t Thread::getStackSize()
+{
+    return this->_stack.size();
 }
 
 /**
@@ -98,98 +203,186 @@ int Thread::getId()
 }
 
 /**
- * Set thread status
- * @param status - READY/RUNNING/BLOCKED
- * @return 0 - success, -1 - failure
+ * get a pointer to the thread's enivronment. (Context Buf)
+ */
+Context* Thread::getEnvironment(){
+    return &(this->_contextBuf);
+}
+
+/**
+ * Set the thread's entry point.
+ * @param ops - how the entry point is moved in, run and destroyed.
+ * @param callable - the entry point, moved into the thread by ops->construct.
+ */
+void Thread::setEntryPoint(const uthread_closure_ops_t *ops, void *callable)
+{
+    ops->construct(this->_entryStorage, callable);
+    this->_entryOps = ops;
+}
+
+/**
+ * Runs the thread's entry point.
  */
-int Thread::setStatus(int status)
+void Thread::runEntryPoint()
 {
-    if (status == READY || status == RUNNING || status == BLOCKED)
-    {
-        this->_status = status;
-        return 0;
+    this->_entryOps->run(this->_entryStorage);
+}
+
+/**
+ * Destroys the thread's entry point, unless it was already.
+ */
+void Thread::clearEntryPoint()
+{
+    if (this->_entryOps) {
+        const uthread_closure_ops_t *ops = this->_entryOps;
+        this->_entryOps = nullptr;
+        ops->destroy(this->_entryStorage);
     }
-    return -1;
 }
 
+
 /**
- * get a pointer to the thread's enivronment. (Context Buf)
+ * Returns the number of quantms the thread with ID tid was in RUNNING state.
  */
-sigjmp_buf* Thread::getEnvironment(){
-    return &(this->_contextBuf);
+int Thread::getNumQuantums()
+{
+    return this->_numQuantums;
 }
 
+/**
+* Increase by 1 the counter of num of quantums the thread was running.
+*/
+void Thread::increaseNumQuantums()
+{
+    _numQuantums++;
+}
 
 /**
- * Get thread's state.
+ * Set the thread's current priority level.
+ * @param level - at least the thread's priority.
  */
-int Thread::getStatus()
+void Thread::setLevel(int level)
+{
+    this->_level = level;
+}
+
+int Thread::getLevel()
 {
-    return this->_status;
+    return this->_level;
 }
 
 /**
- *
- * @param thread
- * @return
+ * Set the priority boost the thread's level is up to date with.
+ * @param epoch
  */
-void Thread::pushDependent(Thread *thread)
+void Thread::setBoostEpoch(unsigned int epoch)
 {
-    this->_dependencyQueue.push(thread);
+    this->_boostEpoch = epoch;
+}
+
+unsigned int Thread::getBoostEpoch()
+{
+    return this->_boostEpoch;
 }
 
 /**
- *
- * @param thread
- * @return
+ * Set whether the thread has an I/O request in flight.
+ * @param flag
  */
-Thread* Thread::popDependent()
+void Thread::setIoPending(bool flag)
 {
-    Thread* t = nullptr;
-    if (!_dependencyQueue.empty())
-    {
-        t = this->_dependencyQueue.front();
-        _dependencyQueue.pop();
+    this->_ioPending = flag;
+}
 
-    }
-    return t;
+bool Thread::isIoPending()
+{
+    return this->_ioPending;
 }
 
 /**
- * Return the number of threads that are synced to this thread.
- * @return
+ * Set whether the thread was terminated, but not destroyed yet.
+ * @param flag
  */
-int Thread::getDependentsNum()
+void Thread::setTerminating(bool flag)
+{
+    this->_terminating = flag;
+}
+
+bool Thread::isTerminating()
 {
-    return this->_dependencyQueue.size();
+    return this->_terminating;
 }
 
 /**
- * Returns the number of quantms the thread with ID tid was in RUNNING state.
+ * Set the result of the thread's last I/O request.
+ * @param result - the transferred bytes, or -errno on failure.
  */
-int Thread::getNumQuantums()
+void Thread::setIoResult(int result)
 {
-    return this->_numQuantums;
+    this->_ioResult = result;
+}
+
+int Thread::getIoResult()
+{
+    return this->_ioResult;
 }
 
 /**
-* Increase by 1 the counter of num of quantums the thread was running.
-*/
-void Thread::increaseNumQuantums()
+ * @return the timer the thread sleeps on.
+ */
+TimerNode* Thread::getTimer()
 {
-    _numQuantums++;
+    return &this->_timer;
 }
 
 /**
- * Raise a flag to indicate whether the thread was synced to another thread.
- * @param flag
+ * Set the wait queue node the thread waits in.
+ * @param node - the node, or nullptr if it does not wait in a queue. A
+ * thread that waits in several queues sets the first of its nodes.
  */
-void Thread::setSynced(bool flag)
+void Thread::setWaitNode(WaitNode *node)
+{
+    this->_waitNode = node;
+}
+
+WaitNode* Thread::getWaitNode()
 {
-    this->_isSynced = flag;
+    return this->_waitNode;
 }
 
-bool Thread::isSynced()
+/**
+ * @return the queue of the threads that wait for this thread to terminate
+ * (uthread_sync etc.).
+ */
+uthread_wait_queue_t* Thread::getExitWaiters()
 {
-    return this->_isSynced;
-}
\ No newline at end of file
+    return &this->_exitWaiters;
+}
+
+/**
+ * @return the thread's values of the thread-local storage keys, indexed by
+ * key.
+ */
+void** Thread::getSpecific()
+{
+    return this->_specific;
+}
+
+/**
+ * @return the generations of the keys the thread's values were set with,
+ * indexed by key.
+ */
+unsigned int* Thread::getSpecificGenerations()
+{
+    return this->_specificGenerations;
+}
+
+/**
+ * @return true if the thread is blocked until an event: an I/O request, its
+ * timer or a wait queue - of a file descriptor, a synchronization object, a
+ * channel or a thread it is synced to.
+ */
+bool Thread::isWaiting()
+{
+    return this->_ioPending || this->_timer.wheel != -1 || this->_waitNode;
+}
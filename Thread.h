@@ -8,11 +8,15 @@
 
 #ifndef EX2_THREAD_H
 #define EX2_THREAD_H
-#define STACK_SIZE 4096
 #include <iostream>
-#include <queue>
-#include <csetjmp>
+#include <cstddef>
 #include <signal.h>
+#include "Stack.h"
+#include "TimerWheel.h"
+#include "WaitQueue.h"
+
+// the size of a cache line, which a thread's hot state is aligned to:
+#define CACHE_LINE_SIZE 64
 
 // status:
 #define READY 1
@@ -23,6 +27,29 @@
 using namespace std;
 typedef unsigned long address_t;
 
+/**
+ * A saved execution context: the callee-saved registers, the stack pointer,
+ * the instruction pointer and the floating point control words. Nothing else
+ * has to survive a call to swapContext(), so nothing else is saved - in
+ * particular, the signal mask is left untouched and no system call is made.
+ */
+struct Context
+{
+#ifdef __x86_64__
+    address_t rbx, rbp, r12, r13, r14, r15, sp, pc;
+    unsigned int mxcsr;
+#else
+    address_t ebx, esi, edi, ebp, sp, pc;
+#endif
+    unsigned short fpucw;
+};
+
+/**
+ * Saves the current context into from and resumes the context in to.
+ * Returns when another swapContext() resumes from.
+ */
+extern "C" void swapContext(Context *from, Context *to);
+
 
 class Thread
 {
@@ -30,48 +57,59 @@ public:
     /**
      * @brief Constructor with thread ID.
      * @param tid - thread ID.
+     * @param launcher - the function the thread's context starts in. It is
+     * expected to call runEntryPoint().
+     * @param stack - the stack the thread runs on. The thread takes ownership
+     * of it. The main thread runs on the process stack, and gets an empty one.
      */
-    Thread(int tid, void (*f)(void), int stackSize);
+    Thread(int tid, void (*launcher)(void), const Stack &stack);
 
     /**
-     * @return Thread ID
+     * @brief Destructor. Destroys the entry point, and releases the thread's
+     * stack.
      */
-    int getId();
+    ~Thread();
 
     /**
-     * Set thread status
-     * @param status - READY/RUNNING/BLOCKED
-     * @return 0 - success, -1 - failure
+     * Re-initializes a terminated thread as a new one, on the same stack.
+     * The entry point of the terminated thread was already destroyed.
+     * @param tid - thread ID.
+     * @param launcher - the function the thread's context starts in.
      */
-    int setStatus(int status);
+    void reset(int tid, void (*launcher)(void));
 
     /**
-     * Get thread's state.
+     * @return the usable size of the thread's stack in bytes.
      */
-    int getStatus();
+    size_t getStackSize();
+
+    /**
+     * @return Thread ID
+     */
+    int getId();
 
     /**
     * get a pointer to the thread's enivronment. (Context Buf)
     */
-    sigjmp_buf* getEnvironment();
+    Context* getEnvironment();
 
     /**
-     * Pushes dependent.
-     * @param thread
+     * Set the thread's entry point.
+     * @param ops - how the entry point is moved in, run and destroyed.
+     * @param callable - the entry point, moved into the thread by
+     * ops->construct.
      */
-    void pushDependent(Thread *thread);
+    void setEntryPoint(const uthread_closure_ops_t *ops, void *callable);
 
     /**
-     * Pops dependent.
-     * @param thread
+     * Runs the thread's entry point.
      */
-    Thread* popDependent();
+    void runEntryPoint();
 
     /**
-     * Return the number of threads that are synced to this thread.
-     * @return
+     * Destroys the thread's entry point, unless it was already.
      */
-    int getDependentsNum();
+    void clearEntryPoint();
 
     /**
      * Returns the number of quantms the thread with ID tid was in RUNNING state.
@@ -83,6 +121,28 @@ public:
      */
     void increaseNumQuantums();
 
+    /**
+     * Set the thread's current priority level.
+     * @param level - at least the thread's priority.
+     */
+    void setLevel(int level);
+
+    /**
+     * @return the thread's current priority level.
+     */
+    int getLevel();
+
+    /**
+     * Set the priority boost the thread's level is up to date with.
+     * @param epoch
+     */
+    void setBoostEpoch(unsigned int epoch);
+
+    /**
+     * @return the priority boost the thread's level is up to date with.
+     */
+    unsigned int getBoostEpoch();
+
     /**
      * Raise a flag to indicate whether thread was blocked by teminate(),
      * but was not synced to another thread.
@@ -98,25 +158,130 @@ public:
     bool getBlockedNoSync();
 
     /**
-     * Raise a flag to indicate whether the thread was synced to another thread.
+     * Set whether the thread has an I/O request in flight.
      * @param flag
      */
-    void setSynced(bool flag);
+    void setIoPending(bool flag);
 
     /**
-     * Return the flag which indicates whether the thread was synced to another
-     * thread.
-     * @return
+     * @return true if the thread has an I/O request in flight.
+     */
+    bool isIoPending();
+
+    /**
+     * Set whether the thread was terminated by another thread, which still
+     * destroys what it left. Until then it is not cached, even if its I/O
+     * request completes.
+     * @param flag
+     */
+    void setTerminating(bool flag);
+
+    /**
+     * @return true if the thread was terminated, but not destroyed yet.
+     */
+    bool isTerminating();
+
+    /**
+     * Set the result of the thread's last I/O request.
+     * @param result - the transferred bytes, or -errno on failure.
+     */
+    void setIoResult(int result);
+
+    /**
+     * @return the result of the thread's last I/O request.
+     */
+    int getIoResult();
+
+    /**
+     * @return the timer the thread sleeps on.
+     */
+    TimerNode* getTimer();
+
+    /**
+     * Set the wait queue node the thread waits in.
+     * @param node - the node, or nullptr if it does not wait in a queue. A
+     * thread that waits in several queues sets the first of its nodes.
+     */
+    void setWaitNode(WaitNode *node);
+
+    /**
+     * @return the wait queue node the thread waits in, or nullptr if it does
+     * not wait in a queue.
+     */
+    WaitNode* getWaitNode();
+
+    /**
+     * @return the queue of the threads that wait for this thread to
+     * terminate (uthread_sync etc.).
+     */
+    uthread_wait_queue_t* getExitWaiters();
+
+    /**
+     * @return the thread's values of the thread-local storage keys, indexed
+     * by key.
+     */
+    void** getSpecific();
+
+    /**
+     * @return the generations of the keys the thread's values were set
+     * with, indexed by key. A value is valid only while its key has that
+     * generation.
+     */
+    unsigned int* getSpecificGenerations();
+
+    /**
+     * @return true if the thread is blocked until an event: an I/O request,
+     * its timer or a wait queue - of a file descriptor, a synchronization
+     * object, a channel or a thread it is synced to.
+     */
+    bool isWaiting();
+
+    /**
+     * Threads are allocated on a cache line boundary, which new does not
+     * guarantee for over-aligned classes before C++17.
      */
-    bool isSynced();
+    static void* operator new(size_t size);
+    static void operator delete(void *ptr);
+
+    /**
+     * @return the size of the hot state of a thread: the bytes from its start
+     * to the end of its context.
+     */
+    static constexpr size_t hotStateSize()
+    {
+        return offsetof(Thread, _contextBuf) + sizeof(Context);
+    }
 
 private:
-    int _tid, _status, _numQuantums;
-    bool _isSynced, _blockedNoSync;
-    char _stack[STACK_SIZE];
-    queue<Thread*> _dependencyQueue;
-    sigjmp_buf _contextBuf;
+    friend class ThreadList;
+    // hot - what a switch to the thread reads or writes, in the first cache
+    // line: links of the list the thread is in, and the state that is not in
+    // the ThreadTable. The status and the priority are there.
+    alignas(CACHE_LINE_SIZE) Thread *_prev;
+    Thread *_next;
+    int _tid, _numQuantums;
+    int _level;
+    unsigned int _boostEpoch;
+    bool _blockedNoSync;
+    bool _ioPending;
+    int _ioResult;
+    // loaded by every switch to the thread, so it starts right after:
+    Context _contextBuf;
+    // cold - waits, the entry point and the stack's bookkeeping:
+    TimerNode _timer;
+    WaitNode *_waitNode;
+    uthread_wait_queue_t _exitWaiters;
+    void *_specific[UTHREAD_KEYS_MAX];
+    unsigned int _specificGenerations[UTHREAD_KEYS_MAX];
+    bool _terminating;
+    const uthread_closure_ops_t *_entryOps;
+    alignas(std::max_align_t) unsigned char _entryStorage[UTHREAD_CLOSURE_SIZE];
+    Stack _stack;
 
 };
 
+// a switch to a thread touches its first two cache lines only:
+static_assert(Thread::hotStateSize() <= 2 * CACHE_LINE_SIZE,
+              "the hot state of a thread spans more than two cache lines");
+
 #endif //EX2_THREAD_H
\ No newline at end of file
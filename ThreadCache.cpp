@@ -0,0 +1,129 @@
+/**
+ * @file ThreadCache.cpp
+ * @brief Keeps terminated threads for reuse by later spawns.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include "ThreadCache.h"
+#include "Thread.h"
+#include "Stack.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @brief Constructor with the high-water mark.
+ * @param limit - the maximal number of cached threads.
+ */
+ThreadCache::ThreadCache(int limit) : _classPages(), _size(0), _limit(limit)
+{
+}
+
+/**
+ * Finds the size class of a page count.
+ * @param pages - the stack size in pages.
+ * @param claim - whether to take the class over if it is empty and kept
+ * another page count.
+ * @return the class, or -1 if it holds threads of another page count.
+ */
+int ThreadCache::sizeClass(size_t pages, bool claim)
+{
+    int sizeClass = (int)(pages % NUM_SIZE_CLASSES);
+    if (_classPages[sizeClass] == pages) {
+        return sizeClass;
+    }
+    if (claim && _classes[sizeClass].empty()) {
+        _classPages[sizeClass] = pages;
+        return sizeClass;
+    }
+    return -1;
+}
+
+/**
+ * Rounds a stack size up to its size class - whole pages. Stacks of cached threads
+ * have to be allocated with a rounded size.
+ * @param stackSize - in bytes.
+ * @return the rounded size in bytes.
+ */
+size_t ThreadCache::roundStackSize(size_t stackSize)
+{
+    size_t pageSize = Stack::pageSize();
+    return (stackSize + pageSize - 1) / pageSize * pageSize;
+}
+
+/**
+ * Takes a cached thread out of the cache.
+ * @param stackSize - the usable stack size the thread needs, in bytes.
+ * @return a thread with a stack of the rounded size, or nullptr if none
+ * is cached.
+ */
+Thread* ThreadCache::get(size_t stackSize)
+{
+    size_t pageSize = Stack::pageSize();
+    int sizeClass = this->sizeClass((stackSize + pageSize - 1) / pageSize,
+                                    false);
+    Thread *thread = sizeClass == -1 ? nullptr : _classes[sizeClass].popFront();
+    if (thread) {
+        _size--;
+    }
+    return thread;
+}
+
+/**
+ * Caches a terminated thread, or deletes it if the cache is full.
+ * @param thread - a thread that is not in any list.
+ */
+void ThreadCache::put(Thread *thread)
+{
+    if (_size >= _limit) {
+        delete thread;
+        return;
+    }
+    int sizeClass = this->sizeClass(thread->getStackSize() / Stack::pageSize(),
+                                    true);
+    if (sizeClass == -1) {
+        delete thread;
+        return;
+    }
+    _classes[sizeClass].pushBack(thread);
+    _size++;
+}
+
+/**
+ * Sets the high-water mark, and deletes the cached threads above it.
+ * @param limit - the maximal number of cached threads.
+ */
+void ThreadCache::setLimit(int limit)
+{
+    _limit = limit;
+    trim(limit);
+}
+
+/**
+ * Deletes cached threads, those with the largest stacks first.
+ * @param keep - the number of cached threads to keep.
+ */
+void ThreadCache::trim(int keep)
+{
+    while (_size > keep) {
+        int largest = -1;
+        for (int sizeClass = 0; sizeClass < NUM_SIZE_CLASSES; sizeClass++) {
+            if (!_classes[sizeClass].empty() && (largest == -1 ||
+                    _classPages[sizeClass] > _classPages[largest])) {
+                largest = sizeClass;
+            }
+        }
+        while (_size > keep && !_classes[largest].empty()) {
+            delete _classes[largest].popFront();
+            _size--;
+        }
+    }
+}
+
+/**
+ * @return the number of cached threads.
+ */
+int ThreadCache::size()
+{
+    return _size;
+}
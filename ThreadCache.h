@@ -0,0 +1,83 @@
+/**
+ * @file ThreadCache.h
+ * @brief Keeps terminated threads for reuse by later spawns.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_THREADCACHE_H
+#define EX2_THREADCACHE_H
+#include <cstddef>
+#include "ThreadList.h"
+
+#define NUM_SIZE_CLASSES 48
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A cache of terminated threads, control block and stack together. Stacks
+ * are rounded to whole pages only, and threads are kept in a size class per
+ * page count, so a spawn reuses any cached thread of its exact size without
+ * remapping. The class of a page count is at its index modulo
+ * NUM_SIZE_CLASSES; while it holds threads of another size, threads of this
+ * size are not cached.
+ */
+class ThreadCache
+{
+public:
+    /**
+     * @brief Constructor with the high-water mark.
+     * @param limit - the maximal number of cached threads.
+     */
+    explicit ThreadCache(int limit);
+
+    /**
+     * Rounds a stack size up to its size class - whole pages. Stacks of cached threads
+     * have to be allocated with a rounded size.
+     * @param stackSize - in bytes.
+     * @return the rounded size in bytes.
+     */
+    static size_t roundStackSize(size_t stackSize);
+
+    /**
+     * Takes a cached thread out of the cache.
+     * @param stackSize - the usable stack size the thread needs, in bytes.
+     * @return a thread with a stack of the rounded size, or nullptr if none
+     * is cached.
+     */
+    Thread* get(size_t stackSize);
+
+    /**
+     * Caches a terminated thread, or deletes it if the cache is full.
+     * @param thread - a thread that is not in any list.
+     */
+    void put(Thread *thread);
+
+    /**
+     * Sets the high-water mark, and deletes the cached threads above it.
+     * @param limit - the maximal number of cached threads.
+     */
+    void setLimit(int limit);
+
+    /**
+     * Deletes cached threads, those with the largest stacks first.
+     * @param keep - the number of cached threads to keep.
+     */
+    void trim(int keep);
+
+    /**
+     * @return the number of cached threads.
+     */
+    int size();
+
+private:
+    int sizeClass(size_t pages, bool claim);
+
+    ThreadList _classes[NUM_SIZE_CLASSES];
+    // the page count of every class, 0 if it was never used:
+    size_t _classPages[NUM_SIZE_CLASSES];
+    int _size, _limit;
+};
+
+#endif //EX2_THREADCACHE_H
@@ -0,0 +1,99 @@
+/**
+ * @file ThreadList.cpp
+ * @brief An intrusive doubly-linked list of threads.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include "ThreadList.h"
+#include "Thread.h"
+
+// ------------------------------- methods ------------------------------
+
+ThreadList::ThreadList() : _head(nullptr), _tail(nullptr), _size(0)
+{
+}
+
+/**
+ * Appends a thread to the end of the list.
+ * @param thread
+ */
+void ThreadList::pushBack(Thread *thread)
+{
+    thread->_prev = _tail;
+    thread->_next = nullptr;
+    if (_tail) {
+        _tail->_next = thread;
+    } else {
+        _head = thread;
+    }
+    _tail = thread;
+    _size++;
+}
+
+/**
+ * Removes the first thread of the list.
+ * @return the removed thread, or nullptr if the list is empty.
+ */
+Thread* ThreadList::popFront()
+{
+    Thread *thread = _head;
+    if (thread) {
+        remove(thread);
+    }
+    return thread;
+}
+
+/**
+ * @return the first thread of the list, or nullptr if the list is empty.
+ */
+Thread* ThreadList::front()
+{
+    return _head;
+}
+
+/**
+ * Removes a thread of the list.
+ * @param thread - a thread that is in the list.
+ */
+void ThreadList::remove(Thread *thread)
+{
+    if (thread->_prev) {
+        thread->_prev->_next = thread->_next;
+    } else {
+        _head = thread->_next;
+    }
+    if (thread->_next) {
+        thread->_next->_prev = thread->_prev;
+    } else {
+        _tail = thread->_prev;
+    }
+    thread->_prev = thread->_next = nullptr;
+    _size--;
+}
+
+/**
+ * Removes all threads from the list.
+ */
+void ThreadList::clear()
+{
+    while (_head) {
+        remove(_head);
+    }
+}
+
+/**
+ * @return the number of threads in the list.
+ */
+int ThreadList::size()
+{
+    return _size;
+}
+
+/**
+ * @return true if the list is empty.
+ */
+bool ThreadList::empty()
+{
+    return _size == 0;
+}
@@ -0,0 +1,69 @@
+/**
+ * @file ThreadList.h
+ * @brief An intrusive doubly-linked list of threads.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_THREADLIST_H
+#define EX2_THREADLIST_H
+
+class Thread;
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A FIFO list of threads, linked through the threads themselves. Nothing is
+ * allocated, and a thread can be removed from any position in O(1).
+ * A thread is in at most one list at a time.
+ */
+class ThreadList
+{
+public:
+    ThreadList();
+
+    /**
+     * Appends a thread to the end of the list.
+     * @param thread
+     */
+    void pushBack(Thread *thread);
+
+    /**
+     * Removes the first thread of the list.
+     * @return the removed thread, or nullptr if the list is empty.
+     */
+    Thread* popFront();
+
+    /**
+     * @return the first thread of the list, or nullptr if the list is empty.
+     */
+    Thread* front();
+
+    /**
+     * Removes a thread of the list.
+     * @param thread - a thread that is in the list.
+     */
+    void remove(Thread *thread);
+
+    /**
+     * Removes all threads from the list.
+     */
+    void clear();
+
+    /**
+     * @return the number of threads in the list.
+     */
+    int size();
+
+    /**
+     * @return true if the list is empty.
+     */
+    bool empty();
+
+private:
+    Thread *_head, *_tail;
+    int _size;
+};
+
+#endif //EX2_THREADLIST_H
@@ -0,0 +1,80 @@
+/**
+ * @file ThreadTable.cpp
+ * @brief Maps thread IDs to threads and their scheduling state.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "ThreadTable.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @brief Constructor with the number of IDs.
+ * @param capacity - IDs are in the range [0, capacity).
+ */
+ThreadTable::ThreadTable(int capacity) :
+        _chunks((capacity + TABLE_CHUNK_SIZE - 1) >> TABLE_CHUNK_SHIFT),
+        _capacity(capacity)
+{
+}
+
+/**
+ * Allocates a chunk on a cache line boundary, with every slot clear.
+ * @param size
+ * @return the memory of the chunk.
+ */
+void* ThreadTable::Chunk::operator new(size_t size)
+{
+    void *ptr;
+    if (posix_memalign(&ptr, CACHE_LINE_SIZE, size)) {
+        throw std::bad_alloc();
+    }
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+void ThreadTable::Chunk::operator delete(void *ptr)
+{
+    free(ptr);
+}
+
+/**
+ * Sets the thread with ID tid. A thread starts READY, at the highest
+ * priority.
+ * @param tid - an ID in the range of the table.
+ * @param thread - the thread, or nullptr to clear the slot.
+ */
+void ThreadTable::set(int tid, Thread *thread)
+{
+    std::unique_ptr<Chunk> &chunk = _chunks[tid >> TABLE_CHUNK_SHIFT];
+    if (!chunk) {
+        chunk.reset(new Chunk);
+    }
+    int slot = tid & (TABLE_CHUNK_SIZE - 1);
+    chunk->threads[slot] = thread;
+    chunk->statuses[slot] = READY;
+    chunk->priorities[slot] = 0;
+    chunk->contexts[slot] = thread ? thread->getEnvironment() : nullptr;
+}
+
+/**
+ * @return the number of IDs.
+ */
+int ThreadTable::capacity() const
+{
+    return _capacity;
+}
+
+/**
+ * Releases all slots. The threads themselves are not deleted.
+ */
+void ThreadTable::clear()
+{
+    std::vector<std::unique_ptr<Chunk>> empty;
+    _chunks.swap(empty);
+    _capacity = 0;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file ThreadTable.h
+ * @brief Maps thread IDs to threads and their scheduling state.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_THREADTABLE_H
+#define EX2_THREADTABLE_H
+#include <vector>
+#include <memory>
+#include "Thread.h"
+
+#define TABLE_CHUNK_SHIFT 12
+#define TABLE_CHUNK_SIZE (1 << TABLE_CHUNK_SHIFT)
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A table of threads indexed by ID, with the state the scheduler reads on
+ * every decision - status, priority and a pointer to the saved context -
+ * kept beside them in an array per field, instead of in the threads. A
+ * scheduling decision reads a few words of these arrays, and the threads'
+ * own memory - their stacks, contexts and wait lists - stays out of line.
+ * Slots are allocated in chunks as IDs are first used, so a large limit
+ * costs nothing until it is reached, and chunks are never moved once
+ * allocated.
+ */
+class ThreadTable
+{
+public:
+    /**
+     * @brief Constructor with the number of IDs.
+     * @param capacity - IDs are in the range [0, capacity).
+     */
+    explicit ThreadTable(int capacity);
+
+    /**
+     * @param tid - an ID in the range of the table.
+     * @return the thread with ID tid, or nullptr if there is none.
+     */
+    Thread* operator[](int tid) const
+    {
+        Chunk *chunk = _chunks[tid >> TABLE_CHUNK_SHIFT].get();
+        return chunk ? chunk->threads[tid & (TABLE_CHUNK_SIZE - 1)] : nullptr;
+    }
+
+    /**
+     * Sets the thread with ID tid. A thread starts READY, at the highest
+     * priority.
+     * @param tid - an ID in the range of the table.
+     * @param thread - the thread, or nullptr to clear the slot.
+     */
+    void set(int tid, Thread *thread);
+
+    /**
+     * @param tid - the ID of a thread in the table.
+     * @return the thread's status: READY/RUNNING/BLOCKED.
+     */
+    int getStatus(int tid) const
+    {
+        return chunkOf(tid)->statuses[tid & (TABLE_CHUNK_SIZE - 1)];
+    }
+
+    /**
+     * Set the status of a thread.
+     * @param tid - the ID of a thread in the table.
+     * @param status - READY/RUNNING/BLOCKED.
+     */
+    void setStatus(int tid, int status)
+    {
+        chunkOf(tid)->statuses[tid & (TABLE_CHUNK_SIZE - 1)] = status;
+    }
+
+    /**
+     * @param tid - the ID of a thread in the table.
+     * @return the thread's priority, 0 being the highest.
+     */
+    int getPriority(int tid) const
+    {
+        return chunkOf(tid)->priorities[tid & (TABLE_CHUNK_SIZE - 1)];
+    }
+
+    /**
+     * Set the priority of a thread. Its level is up to the caller.
+     * @param tid - the ID of a thread in the table.
+     * @param priority - 0 is the highest.
+     */
+    void setPriority(int tid, int priority)
+    {
+        chunkOf(tid)->priorities[tid & (TABLE_CHUNK_SIZE - 1)] = priority;
+    }
+
+    /**
+     * @param tid - the ID of a thread in the table.
+     * @return the thread's saved context.
+     */
+    Context* getContext(int tid) const
+    {
+        return chunkOf(tid)->contexts[tid & (TABLE_CHUNK_SIZE - 1)];
+    }
+
+    /**
+     * @return the number of IDs.
+     */
+    int capacity() const;
+
+    /**
+     * Releases all slots. The threads themselves are not deleted.
+     */
+    void clear();
+
+private:
+    // the slots of TABLE_CHUNK_SIZE IDs, an array per field. Every array is
+    // a whole number of cache lines, so each starts on a line of its own:
+    struct Chunk
+    {
+        alignas(CACHE_LINE_SIZE) Thread *threads[TABLE_CHUNK_SIZE];
+        int statuses[TABLE_CHUNK_SIZE];
+        int priorities[TABLE_CHUNK_SIZE];
+        Context *contexts[TABLE_CHUNK_SIZE];
+
+        static void* operator new(size_t size);
+        static void operator delete(void *ptr);
+    };
+
+    Chunk* chunkOf(int tid) const
+    {
+        return _chunks[tid >> TABLE_CHUNK_SHIFT].get();
+    }
+
+    std::vector<std::unique_ptr<Chunk>> _chunks;
+    int _capacity;
+};
+
+#endif //EX2_THREADTABLE_H
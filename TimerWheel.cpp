@@ -0,0 +1,190 @@
+/**
+ * @file TimerWheel.cpp
+ * @brief Timers of sleeping threads, in a hierarchical timing wheel.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include <algorithm>
+#include "TimerWheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @return word rotated left by n bits.
+ */
+static uint64_t rotateLeft(uint64_t word, int n)
+{
+    n &= 63;
+    return n ? (word << n) | (word >> (64 - n)) : word;
+}
+
+/**
+ * @return word rotated right by n bits.
+ */
+static uint64_t rotateRight(uint64_t word, int n)
+{
+    n &= 63;
+    return n ? (word >> n) | (word << (64 - n)) : word;
+}
+
+TimerWheel::TimerWheel() : _now(0), _size(0)
+{
+    for (int wheel = 0; wheel < TIMER_WHEEL_NUM; wheel++) {
+        _pending[wheel] = 0;
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            _slots[wheel][slot] = nullptr;
+        }
+    }
+}
+
+/**
+ * Arms a timer.
+ * @param node - a timer that is not armed.
+ * @param expiry - in ticks. a timer that is already due expires at the
+ * next tick.
+ */
+void TimerWheel::add(TimerNode *node, uint64_t expiry)
+{
+    uint64_t remaining = expiry > _now ? expiry - _now : 1;
+    remaining = std::min(remaining, TIMER_WHEEL_MAX_TIMEOUT);
+    node->expiry = _now + remaining;
+    // the wheel is picked by how far away the timer is. timers of the higher
+    // wheels are put one slot early, so that they are moved down a wheel when
+    // the lower wheels wrap around to their expiry:
+    node->wheel = (63 - __builtin_clzll(remaining)) / TIMER_WHEEL_BITS;
+    node->slot = (int)(SLOT_MASK & ((node->expiry >>
+                                     (node->wheel * TIMER_WHEEL_BITS)) -
+                                    (node->wheel ? 1 : 0)));
+    TimerNode *&head = _slots[node->wheel][node->slot];
+    node->prev = nullptr;
+    node->next = head;
+    if (head) {
+        head->prev = node;
+    }
+    head = node;
+    _pending[node->wheel] |= (uint64_t)1 << node->slot;
+    _size++;
+}
+
+/**
+ * Disarms a timer before it expires.
+ * @param node - an armed timer.
+ */
+void TimerWheel::cancel(TimerNode *node)
+{
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        _slots[node->wheel][node->slot] = node->next;
+        if (!node->next) {
+            _pending[node->wheel] &= ~((uint64_t)1 << node->slot);
+        }
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    node->prev = node->next = nullptr;
+    node->wheel = node->slot = -1;
+    _size--;
+}
+
+/**
+ * Advances the current time, and expires the timers that are due.
+ * @param now - in ticks, not before the current time.
+ * @param expire - called for every expired timer, after it is disarmed.
+ * @return the number of expired timers.
+ */
+int TimerWheel::advance(uint64_t now, void (*expire)(TimerNode *))
+{
+    uint64_t elapsed = now - _now;
+    // the collected timers, in the order of their slots:
+    TimerNode *due = nullptr, **dueTail = &due;
+    for (int wheel = 0; wheel < TIMER_WHEEL_NUM; wheel++) {
+        int shift = wheel * TIMER_WHEEL_BITS;
+        uint64_t passed;
+        if ((elapsed >> shift) > SLOT_MASK) {
+            // a whole rotation of the wheel has passed:
+            passed = ~(uint64_t)0;
+        } else {
+            // the slots from the old time to the new one, inclusive:
+            int steps = (int)(SLOT_MASK & (elapsed >> shift));
+            int oldSlot = (int)(SLOT_MASK & (_now >> shift));
+            int newSlot = (int)(SLOT_MASK & (now >> shift));
+            uint64_t span = ((uint64_t)1 << steps) - 1;
+            passed = rotateLeft(span, oldSlot) |
+                     rotateRight(rotateLeft(span, newSlot), steps) |
+                     (uint64_t)1 << newSlot;
+        }
+        // collect the timers of the passed slots, from the earliest one:
+        int firstSlot = (int)(SLOT_MASK & (_now >> shift));
+        uint64_t slots;
+        while ((slots = rotateRight(passed & _pending[wheel], firstSlot))) {
+            int slot = (__builtin_ctzll(slots) + firstSlot) & SLOT_MASK;
+            *dueTail = _slots[wheel][slot];
+            while (*dueTail) {
+                dueTail = &(*dueTail)->next;
+            }
+            _slots[wheel][slot] = nullptr;
+            _pending[wheel] &= ~((uint64_t)1 << slot);
+        }
+        // the next wheel only moves if this one wrapped around:
+        if (!(passed & 1)) {
+            break;
+        }
+        elapsed = std::max(elapsed, (uint64_t)TIMER_WHEEL_SLOTS << shift);
+    }
+    _now = now;
+    // expire the collected timers that are due, and move the others down:
+    int expired = 0;
+    while (due) {
+        TimerNode *node = due;
+        due = node->next;
+        _size--;
+        if (node->expiry <= now) {
+            node->prev = node->next = nullptr;
+            node->wheel = node->slot = -1;
+            expired++;
+            expire(node);
+        } else {
+            add(node, node->expiry);
+        }
+    }
+    return expired;
+}
+
+/**
+ * @return the number of ticks from the current time until the time should
+ * be advanced next - when a timer is due, or when timers have to be moved
+ * down a wheel. UINT64_MAX if there are no timers.
+ */
+uint64_t TimerWheel::timeout()
+{
+    uint64_t timeout = UINT64_MAX;
+    // the part of the current time that the lower wheels stand for:
+    uint64_t lowerMask = 0;
+    for (int wheel = 0; wheel < TIMER_WHEEL_NUM; wheel++) {
+        int shift = wheel * TIMER_WHEEL_BITS;
+        if (_pending[wheel]) {
+            int slot = (int)(SLOT_MASK & (_now >> shift));
+            // timers of the higher wheels are a rotation ahead of their slot:
+            uint64_t wheelTimeout =
+                    ((uint64_t)__builtin_ctzll(rotateRight(_pending[wheel], slot))
+                     + (wheel ? 1 : 0)) << shift;
+            wheelTimeout -= lowerMask & _now;
+            timeout = std::min(timeout, wheelTimeout);
+        }
+        lowerMask = (lowerMask << TIMER_WHEEL_BITS) | SLOT_MASK;
+    }
+    return timeout;
+}
+
+/**
+ * @return the number of armed timers.
+ */
+int TimerWheel::size()
+{
+    return _size;
+}
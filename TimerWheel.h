@@ -0,0 +1,96 @@
+/**
+ * @file TimerWheel.h
+ * @brief Timers of sleeping threads, in a hierarchical timing wheel.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_TIMERWHEEL_H
+#define EX2_TIMERWHEEL_H
+#include <cstdint>
+
+// the wheels have 2^TIMER_WHEEL_BITS slots each:
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_NUM 6
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+// the furthest expiry a timer can have, in ticks from the current time. a
+// timer that is further away expires early:
+#define TIMER_WHEEL_MAX_TIMEOUT \
+    (((uint64_t)1 << (TIMER_WHEEL_BITS * TIMER_WHEEL_NUM)) - 1)
+
+class Thread;
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * A timer, linked into a slot of the wheel it is in.
+ */
+struct TimerNode
+{
+    TimerNode *prev, *next;
+    // in ticks:
+    uint64_t expiry;
+    // the wheel and the slot the timer is in, or -1 if it is not armed:
+    int wheel, slot;
+    Thread *thread;
+    TimerNode(): prev(nullptr), next(nullptr), expiry(0), wheel(-1), slot(-1),
+                 thread(nullptr) {}
+};
+
+/**
+ * Timers kept in TIMER_WHEEL_NUM wheels of TIMER_WHEEL_SLOTS slots. Wheel i
+ * holds the timers that are between 2^(i*TIMER_WHEEL_BITS) and
+ * 2^((i+1)*TIMER_WHEEL_BITS) ticks away, in the slot of their expiry. Adding
+ * and cancelling a timer is O(1). When the time advances, the slots it passed
+ * are found with a bitmap of the non-empty slots per wheel; their timers are
+ * either expired, or moved down to a lower wheel.
+ */
+class TimerWheel
+{
+public:
+    TimerWheel();
+
+    /**
+     * Arms a timer.
+     * @param node - a timer that is not armed.
+     * @param expiry - in ticks. a timer that is already due expires at the
+     * next tick.
+     */
+    void add(TimerNode *node, uint64_t expiry);
+
+    /**
+     * Disarms a timer before it expires.
+     * @param node - an armed timer.
+     */
+    void cancel(TimerNode *node);
+
+    /**
+     * Advances the current time, and expires the timers that are due.
+     * @param now - in ticks, not before the current time.
+     * @param expire - called for every expired timer, after it is disarmed.
+     * @return the number of expired timers.
+     */
+    int advance(uint64_t now, void (*expire)(TimerNode *));
+
+    /**
+     * @return the number of ticks from the current time until the time should
+     * be advanced next - when a timer is due, or when timers have to be moved
+     * down a wheel. UINT64_MAX if there are no timers.
+     */
+    uint64_t timeout();
+
+    /**
+     * @return the number of armed timers.
+     */
+    int size();
+
+private:
+    TimerNode *_slots[TIMER_WHEEL_NUM][TIMER_WHEEL_SLOTS];
+    // bit i of _pending[w] is set if slot i of wheel w is not empty:
+    uint64_t _pending[TIMER_WHEEL_NUM];
+    uint64_t _now;
+    int _size;
+};
+
+#endif //EX2_TIMERWHEEL_H
@@ -0,0 +1,77 @@
+/**
+ * @file WaitQueue.cpp
+ * @brief A FIFO queue of threads that wait for a synchronization object.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+#include "WaitQueue.h"
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * @brief Constructor with the queue to operate on.
+ * @param queue
+ */
+WaitQueue::WaitQueue(uthread_wait_queue_t *queue) : _queue(queue)
+{
+}
+
+/**
+ * Appends a node to the end of the queue.
+ * @param node - a node that is not queued.
+ */
+void WaitQueue::pushBack(WaitNode *node)
+{
+    WaitNode *tail = (WaitNode *)_queue->tail;
+    node->prev = tail;
+    node->next = nullptr;
+    node->queue = _queue;
+    if (tail) {
+        tail->next = node;
+    } else {
+        _queue->head = node;
+    }
+    _queue->tail = node;
+}
+
+/**
+ * Removes the first node of the queue.
+ * @return the removed node, or nullptr if the queue is empty.
+ */
+WaitNode* WaitQueue::popFront()
+{
+    WaitNode *node = (WaitNode *)_queue->head;
+    if (node) {
+        remove(node);
+    }
+    return node;
+}
+
+/**
+ * Removes a node of the queue.
+ * @param node - a node that is in the queue.
+ */
+void WaitQueue::remove(WaitNode *node)
+{
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        _queue->head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        _queue->tail = node->prev;
+    }
+    node->prev = node->next = nullptr;
+    node->queue = nullptr;
+}
+
+/**
+ * @return true if the queue is empty.
+ */
+bool WaitQueue::empty()
+{
+    return !_queue->head;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file WaitQueue.h
+ * @brief A FIFO queue of threads that wait for a synchronization object.
+ *
+ */
+
+// ------------------------------ includes ------------------------------
+
+#ifndef EX2_WAITQUEUE_H
+#define EX2_WAITQUEUE_H
+#include "uthreads.h"
+
+class Thread;
+
+// ------------------------------- methods ------------------------------
+
+/**
+ * The registration of a waiting thread in a wait queue. It lives on the
+ * stack of the thread for as long as it waits, so queueing allocates nothing.
+ * A thread that waits for several things at once has a node in each of their
+ * queues, chained through sibling.
+ */
+struct WaitNode
+{
+    WaitNode *prev, *next;
+    Thread *thread;
+    // the queue the node is in, or nullptr if it is not queued:
+    uthread_wait_queue_t *queue;
+    // what the thread waits with, e.g. the mutex a condition variable waiter
+    // gets back:
+    void *data;
+    // the next node of the same thread, or nullptr:
+    WaitNode *sibling;
+    // the file descriptor the node waits for in the reactor, or -1:
+    int fd;
+    // set for the node that woke the thread up:
+    bool woken;
+    WaitNode(Thread *waiter, void *waitData): prev(nullptr), next(nullptr),
+                                            thread(waiter), queue(nullptr),
+                                            data(waitData), sibling(nullptr),
+                                            fd(-1), woken(false) {}
+};
+
+/**
+ * Operations on the wait queue of a synchronization object. The queue itself
+ * is part of the object, which is defined by the public interface, so this
+ * class only refers to it.
+ */
+class WaitQueue
+{
+public:
+    /**
+     * @brief Constructor with the queue to operate on.
+     * @param queue
+     */
+    explicit WaitQueue(uthread_wait_queue_t *queue);
+
+    /**
+     * Appends a node to the end of the queue.
+     * @param node - a node that is not queued.
+     */
+    void pushBack(WaitNode *node);
+
+    /**
+     * Removes the first node of the queue.
+     * @return the removed node, or nullptr if the queue is empty.
+     */
+    WaitNode* popFront();
+
+    /**
+     * Removes a node of the queue.
+     * @param node - a node that is in the queue.
+     */
+    void remove(WaitNode *node);
+
+    /**
+     * @return true if the queue is empty.
+     */
+    bool empty();
+
+private:
+    uthread_wait_queue_t *_queue;
+};
+
+#endif //EX2_WAITQUEUE_H
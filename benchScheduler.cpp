@@ -0,0 +1,96 @@
+/**********************************************
+ * Benchmark: the cost of a scheduling decision with many threads
+ *
+ * NUM_THREADS threads yield to each other round-robin, so every yield is one
+ * scheduler() call that switches to a thread that ran NUM_THREADS switches
+ * ago - whose state is no longer in the cache. prints the time and, where
+ * the kernel exposes hardware counters, the cache misses per call. the time
+ * alone does not show the layout of the scheduling state: re-arming the
+ * timer and touching the next thread's stack take most of it.
+ *
+ * build: make && g++ -O2 -std=c++11 benchScheduler.cpp libuthreads.a
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "uthreads.h"
+
+#define NUM_THREADS 10000
+#define NUM_ROUNDS 20
+// long enough that no thread is preempted:
+#define QUANTUM_USECS 10000000
+
+/**
+ * Opens a counter of the cache misses of this process in user space.
+ * @return its file descriptor, or -1 if the kernel does not expose it.
+ */
+int open_cache_misses()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+long long read_counter(int fd)
+{
+    long long value = 0;
+    if (fd == -1 || read(fd, &value, sizeof(value)) != sizeof(value))
+    {
+        return -1;
+    }
+    return value;
+}
+
+double now_nsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void yielder()
+{
+    for (int i = 0; i < NUM_ROUNDS; i++)
+    {
+        uthread_yield();
+    }
+}
+
+int main()
+{
+    uthread_init_ex(QUANTUM_USECS, NUM_THREADS + 1);
+    static int tids[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        tids[i] = uthread_spawn(yielder);
+    }
+    // every thread runs once, so its stack and state are allocated:
+    uthread_yield();
+
+    int fd = open_cache_misses();
+    long long misses = read_counter(fd);
+    double start = now_nsec();
+    uthread_sync_all(tids, NUM_THREADS);
+    double elapsed = now_nsec() - start;
+    long long calls = (long long)NUM_THREADS * NUM_ROUNDS;
+
+    printf("%d threads: %.1f ns per scheduler() call", NUM_THREADS,
+           elapsed / calls);
+    if (misses != -1)
+    {
+        printf(", %.2f cache misses per call",
+               (double)(read_counter(fd) - misses) / calls);
+    }
+    printf("\n");
+    uthread_terminate(0);
+}
@@ -0,0 +1,96 @@
+/**********************************************
+ * Test 10: quantums of thread CPU time
+ *
+ * threads that never yield preempt each other round-robin, and each of them
+ * is counted a quantum per preemption. a quantum is CPU time of the kernel
+ * thread that runs the threads: it does not pass while that kernel thread
+ * sleeps, even when another kernel thread of the process keeps a CPU busy.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <unistd.h>
+#include <pthread.h>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_SPINNERS 3
+#define NUM_QUANTUMS 20
+#define QUANTUM_USECS 10000
+#define SLEEP_QUANTUMS 20
+
+int tids[NUM_SPINNERS];
+bool finished[NUM_SPINNERS];
+volatile bool burning = true;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void spinner()
+{
+    while (uthread_get_quantums(uthread_get_tid()) < NUM_QUANTUMS)
+    {
+    }
+    // the others started their last quantum before this one did, or will
+    // start it next:
+    for (int i = 0; i < NUM_SPINNERS; i++)
+    {
+        if (finished[i])
+        {
+            continue;
+        }
+        int quantums = uthread_get_quantums(tids[i]);
+        if (quantums < NUM_QUANTUMS - 1 || quantums > NUM_QUANTUMS)
+        {
+            fail("the threads were not preempted round-robin");
+        }
+    }
+    // spawned first, so the IDs are 1 to NUM_SPINNERS:
+    finished[uthread_get_tid() - 1] = true;
+}
+
+// a kernel thread that keeps a CPU busy, and does not use the library:
+void *burner(void *)
+{
+    while (burning)
+    {
+    }
+    return nullptr;
+}
+
+int main()
+{
+    printf(GRN "Test 10:   " RESET);
+    fflush(stdout);
+
+    uthread_init(QUANTUM_USECS);
+    for (int i = 0; i < NUM_SPINNERS; i++)
+    {
+        tids[i] = uthread_spawn(spinner);
+    }
+    uthread_sync_all(tids, NUM_SPINNERS);
+
+    // no quantum passes while this kernel thread sleeps:
+    pthread_t burner_thread;
+    if (pthread_create(&burner_thread, nullptr, burner, nullptr))
+    {
+        fail("the burner was not created");
+    }
+    int quantums = uthread_get_total_quantums();
+    usleep(SLEEP_QUANTUMS * QUANTUM_USECS);
+    burning = false;
+    pthread_join(burner_thread, nullptr);
+    if (uthread_get_total_quantums() != quantums)
+    {
+        fail("a quantum passed while the thread slept");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
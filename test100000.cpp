@@ -0,0 +1,131 @@
+/**********************************************
+ * Test 100000: many threads
+ *
+ * with a limit of a million threads, as many threads are spawned at once as
+ * the kernel's map count allows - every stack takes two mappings - up to
+ * 100000, and then more are spawned while others are terminated, until
+ * 100000 were spawned. IDs are always the smallest free ones, and every
+ * thread is found by its ID. a limit past MAX_THREAD_LIMIT is refused.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <climits>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define MAX_THREADS (1 << 20)
+#define NUM_THREADS 100000
+// the mappings of the stacks, and room for the rest of the process:
+#define MAPS_PER_THREAD 2
+#define MAPS_RESERVED 1000
+// long enough that the main thread is not preempted:
+#define QUANTUM_USECS 100000000
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+// the spawned threads stay READY, and never run:
+void never_run()
+{
+    fail("a thread ran");
+}
+
+/**
+ * @return the number of threads whose stacks can be mapped at once.
+ */
+int max_live_threads()
+{
+    int max_map_count = 65530;
+    FILE *file = fopen("/proc/sys/vm/max_map_count", "r");
+    if (file)
+    {
+        if (fscanf(file, "%d", &max_map_count) != 1)
+        {
+            max_map_count = 65530;
+        }
+        fclose(file);
+    }
+    int live = (max_map_count - MAPS_RESERVED) / MAPS_PER_THREAD;
+    return live < NUM_THREADS ? live : NUM_THREADS;
+}
+
+int main()
+{
+    printf(GRN "Test 100000: " RESET);
+    fflush(stdout);
+
+    if (uthread_init_ex(QUANTUM_USECS, INT_MAX) != -1 ||
+        uthread_init_ex(QUANTUM_USECS, MAX_THREAD_LIMIT + 1) != -1)
+    {
+        printf(RED "ERROR - a limit past MAX_THREAD_LIMIT was accepted\n"
+               RESET);
+        return 1;
+    }
+    if (uthread_init_ex(QUANTUM_USECS, MAX_THREADS))
+    {
+        fail("init with a million threads failed");
+    }
+    int live = max_live_threads();
+
+    // IDs are handed out in order:
+    for (int i = 1; i <= live; i++)
+    {
+        if (uthread_spawn(never_run) != i)
+        {
+            fail("a thread did not get the smallest free ID");
+        }
+    }
+    int spawned = live;
+
+    // the IDs of terminated threads are reused, smallest first:
+    for (int tid = 1; tid <= live; tid += 2)
+    {
+        uthread_terminate(tid);
+    }
+    for (int tid = 1; tid <= live; tid += 2)
+    {
+        if (uthread_spawn(never_run) != tid)
+        {
+            fail("a terminated thread's ID was not reused in order");
+        }
+        spawned++;
+    }
+
+    // and the rest is spawned as others are terminated:
+    for (int tid = live; spawned < NUM_THREADS; spawned++)
+    {
+        uthread_terminate(tid);
+        if (uthread_spawn(never_run) != tid)
+        {
+            fail("a terminated thread's ID was not reused");
+        }
+        tid = tid > 1 ? tid - 1 : live;
+    }
+
+    // every thread is found by its ID:
+    for (int tid = 1; tid <= live; tid++)
+    {
+        if (uthread_get_quantums(tid) != 0)
+        {
+            fail("a thread was not found by its ID");
+        }
+    }
+    for (int tid = 1; tid <= live; tid++)
+    {
+        uthread_terminate(tid);
+    }
+    if (uthread_spawn(never_run) != 1)
+    {
+        fail("the IDs were not free again");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -0,0 +1,77 @@
+/**********************************************
+ * Test 11: yield
+ *
+ * two threads hand the CPU back and forth with uthread_yield, and each
+ * hand-off has to start a new quantum right away.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define ROUNDS 1000
+
+int turn = 1;
+bool failed = false;
+
+void ping_pong(int me, int other)
+{
+    for (int i = 0; i < ROUNDS; i++)
+    {
+        if (turn != me)
+        {
+            failed = true;
+        }
+        turn = other;
+        uthread_yield();
+    }
+    uthread_block(uthread_get_tid());
+}
+
+void thread1()
+{
+    ping_pong(1, 2);
+}
+
+void thread2()
+{
+    ping_pong(2, 1);
+}
+
+int main()
+{
+    printf(GRN "Test 11:   " RESET);
+    fflush(stdout);
+
+    // a long quantum, so the timer does not take part:
+    uthread_init(10000000);
+
+    // with no other thread READY, yield returns right away:
+    int quantums = uthread_get_total_quantums();
+    uthread_yield();
+    if (uthread_get_total_quantums() != quantums)
+    {
+        printf(RED "ERROR - yield without READY threads started a quantum\n" RESET);
+        uthread_terminate(0);
+    }
+
+    // main stays below the two threads, so it does not take turns:
+    uthread_set_priority(0, 1);
+    uthread_spawn(thread1);
+    uthread_spawn(thread2);
+    uthread_yield();
+
+    if (failed || uthread_get_quantums(1) != ROUNDS + 1 ||
+        uthread_get_quantums(2) != ROUNDS + 1)
+    {
+        printf(RED "ERROR - threads did not alternate\n" RESET);
+        uthread_terminate(0);
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -0,0 +1,97 @@
+/**********************************************
+ * Test 12: directed hand-off
+ *
+ * a producer yields directly to the last READY thread, and resumes a
+ * blocked consumer with a hand-off; both have to run before the threads
+ * ahead of them in the READY list.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_THREADS 4
+
+int run_order[2 * NUM_THREADS];
+int num_ran = 0;
+
+void record()
+{
+    run_order[num_ran++] = uthread_get_tid();
+}
+
+void error(const char *message)
+{
+    printf(RED "ERROR - %s\n" RESET, message);
+    uthread_terminate(0);
+}
+
+void waiter()
+{
+    record();
+    uthread_block(uthread_get_tid());
+    record();
+    uthread_block(uthread_get_tid());
+}
+
+void consumer()
+{
+    record();
+    uthread_block(uthread_get_tid());
+    record();
+    uthread_block(uthread_get_tid());
+}
+
+void producer()
+{
+    record();
+    // thread 3 is READY behind thread 2:
+    uthread_yield_to(3);
+    record();
+    // thread 3 is BLOCKED - resume it, and hand off to it right away:
+    uthread_resume(2);
+    uthread_resume_ex(3, UTHREAD_HANDOFF);
+    record();
+    uthread_block(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 12:   " RESET);
+    fflush(stdout);
+
+    // a long quantum, so the timer does not take part:
+    uthread_init(10000000);
+    uthread_set_priority(0, 1);
+    uthread_spawn(producer);
+    uthread_spawn(waiter);
+    uthread_spawn(consumer);
+
+    if (uthread_yield_to(NUM_THREADS) != -1)
+    {
+        error("yield to a missing thread succeeded");
+    }
+    uthread_yield();
+
+    // 1 yields to 3, 3 blocks, 2 runs and blocks, 1 resumes 2 and hands off
+    // to 3 ahead of it, 3 blocks, then 2 and 1 run in order.
+    int expected[] = {1, 3, 2, 1, 3, 2, 1};
+    if (num_ran != 7)
+    {
+        error("wrong number of runs");
+    }
+    for (int i = 0; i < 7; i++)
+    {
+        if (run_order[i] != expected[i])
+        {
+            error("threads ran in the wrong order");
+        }
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
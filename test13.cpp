@@ -0,0 +1,269 @@
+/**********************************************
+ * Test 13: blocking I/O through the reactor
+ *
+ * a thread that reads an empty pipe is parked while main keeps running,
+ * two threads stream 1 MiB through a socketpair (so writes block as well as
+ * reads), a parked thread is terminated, a thread that blocked itself and
+ * was resumed still wakes up from I/O, sleep and a mutex, a reader wakes up
+ * while other threads only yield, and main connects to a thread that
+ * accepts on a TCP socket.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define STREAM_SIZE (1024 * 1024)
+#define CHUNK 4096
+#define RUN 0
+#define DONE 1
+
+int pipe_fds[2], pair_fds[2], listen_fd;
+char thread_status[10];
+char received[16];
+int streamed = 0;
+bool stream_ok = true;
+uthread_mutex_t mutex = UTHREAD_MUTEX_INITIALIZER;
+bool resumed_done = false;
+bool yield_done = false;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void wait_quantums(int n)
+{
+    int start = uthread_get_total_quantums();
+    while (uthread_get_total_quantums() < start + n)
+    {}
+}
+
+void reader()
+{
+    if (uthread_read(pipe_fds[0], received, sizeof(received)) != 5)
+    {
+        fail("reading the pipe failed");
+    }
+    thread_status[uthread_get_tid()] = DONE;
+    uthread_terminate(uthread_get_tid());
+}
+
+void producer()
+{
+    char chunk[CHUNK];
+    for (int sent = 0; sent < STREAM_SIZE; sent += CHUNK)
+    {
+        for (int i = 0; i < CHUNK; i++)
+        {
+            chunk[i] = (char)((sent + i) % 251);
+        }
+        for (int off = 0; off < CHUNK;)
+        {
+            ssize_t n = uthread_write(pair_fds[0], chunk + off, CHUNK - off);
+            if (n <= 0)
+            {
+                fail("writing the socketpair failed");
+            }
+            off += n;
+        }
+    }
+    thread_status[uthread_get_tid()] = DONE;
+    uthread_terminate(uthread_get_tid());
+}
+
+void consumer()
+{
+    char chunk[CHUNK];
+    while (streamed < STREAM_SIZE)
+    {
+        ssize_t n = uthread_read(pair_fds[1], chunk, sizeof(chunk));
+        if (n <= 0)
+        {
+            fail("reading the socketpair failed");
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (chunk[i] != (char)((streamed + i) % 251))
+            {
+                stream_ok = false;
+            }
+        }
+        streamed += n;
+    }
+    thread_status[uthread_get_tid()] = DONE;
+    uthread_terminate(uthread_get_tid());
+}
+
+void stuck_reader()
+{
+    char c;
+    uthread_read(pipe_fds[0], &c, 1);
+    fail("a terminated thread was woken up");
+}
+
+void self_blocker()
+{
+    uthread_block(uthread_get_tid());
+    // resumed - it waits like any other thread:
+    char c;
+    if (uthread_read(pipe_fds[0], &c, 1) != 1)
+    {
+        fail("a resumed thread did not read the pipe");
+    }
+    uthread_sleep_usec(1000);
+    uthread_mutex_lock(&mutex);
+    uthread_mutex_unlock(&mutex);
+    resumed_done = true;
+    uthread_terminate(uthread_get_tid());
+}
+
+void yielding_reader()
+{
+    char c;
+    if (uthread_read(pair_fds[1], &c, 1) != 1)
+    {
+        fail("reading the socketpair failed");
+    }
+    yield_done = true;
+    uthread_terminate(uthread_get_tid());
+}
+
+void yielder()
+{
+    while (!yield_done)
+    {
+        uthread_yield();
+    }
+    uthread_terminate(uthread_get_tid());
+}
+
+void server()
+{
+    char request[8];
+    int fd = uthread_accept(listen_fd, nullptr, nullptr);
+    if (fd == -1 || uthread_read(fd, request, 5) != 5 ||
+        memcmp(request, "hello", 5) || uthread_write(fd, "world", 5) != 5)
+    {
+        fail("serving the connection failed");
+    }
+    uthread_close(fd);
+    thread_status[uthread_get_tid()] = DONE;
+    uthread_terminate(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 13:   " RESET);
+    fflush(stdout);
+
+    uthread_init(1000);
+    if (pipe(pipe_fds) || socketpair(AF_UNIX, SOCK_STREAM, 0, pair_fds))
+    {
+        fail("creating the file descriptors failed");
+    }
+
+    // main runs while the reader is parked:
+    int t1 = uthread_spawn(reader);
+    wait_quantums(10);
+    if (thread_status[t1] != RUN)
+    {
+        fail("the reader did not wait for data");
+    }
+    uthread_resume(t1);
+    wait_quantums(3);
+    if (thread_status[t1] != RUN)
+    {
+        fail("a thread waiting for data was resumed");
+    }
+    if (uthread_write(pipe_fds[1], "ping", 5) != 5)
+    {
+        fail("writing the pipe failed");
+    }
+    while (thread_status[t1] == RUN)
+    {}
+    if (strcmp(received, "ping"))
+    {
+        fail("the reader got wrong data");
+    }
+
+    // both sides of the socketpair block:
+    int t2 = uthread_spawn(producer);
+    int t3 = uthread_spawn(consumer);
+    while (thread_status[t2] == RUN || thread_status[t3] == RUN)
+    {}
+    if (!stream_ok || streamed != STREAM_SIZE)
+    {
+        fail("the stream was corrupted");
+    }
+
+    // a parked thread can be terminated:
+    int t4 = uthread_spawn(stuck_reader);
+    wait_quantums(3);
+    uthread_terminate(t4);
+
+    // a thread that blocked itself is woken up normally once resumed:
+    int t6 = uthread_spawn(self_blocker);
+    wait_quantums(3);
+    uthread_resume(t6);
+    wait_quantums(3);
+    uthread_mutex_lock(&mutex);
+    if (uthread_write(pipe_fds[1], "x", 1) != 1)
+    {
+        fail("writing the pipe failed");
+    }
+    wait_quantums(10);
+    uthread_mutex_unlock(&mutex);
+    while (!resumed_done)
+    {}
+    uthread_close(pipe_fds[1]);
+    uthread_close(pipe_fds[0]);
+
+    // threads that only yield never let the quantum expire:
+    int tids[3];
+    tids[0] = uthread_spawn(yielding_reader);
+    uthread_yield();
+    tids[1] = uthread_spawn(yielder);
+    tids[2] = uthread_spawn(yielder);
+    if (uthread_write(pair_fds[0], "x", 1) != 1)
+    {
+        fail("writing the socketpair failed");
+    }
+    uthread_sync_all(tids, 3);
+
+    // main blocks in connect and read, while the server runs:
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd == -1 || bind(listen_fd, (struct sockaddr *)&addr, len) ||
+        listen(listen_fd, 1) ||
+        getsockname(listen_fd, (struct sockaddr *)&addr, &len))
+    {
+        fail("creating the listening socket failed");
+    }
+    int t5 = uthread_spawn(server);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    char reply[8] = {};
+    if (uthread_connect(fd, (struct sockaddr *)&addr, len) ||
+        uthread_write(fd, "hello", 5) != 5 || uthread_read(fd, reply, 5) != 5 ||
+        strcmp(reply, "world"))
+    {
+        fail("the client failed");
+    }
+    while (thread_status[t5] == RUN)
+    {}
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -0,0 +1,136 @@
+/**********************************************
+ * Test 15: sleeping threads
+ *
+ * threads sleep for different times and wake up in the order of their
+ * deadlines, never before them; a sleeping thread is not resumed early,
+ * main sleeps as well, and a sleeper wakes up while other threads keep
+ * yielding to each other.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <ctime>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_SLEEPERS 10
+#define STEP_USEC 20000
+#define NUM_SPINNERS 2
+
+int woke_order[NUM_SLEEPERS + 1];
+int num_woke = 0;
+bool woke_early = false;
+bool spinner_woke = false;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+long long now_usec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+// thread i sleeps for (NUM_SLEEPERS + 1 - i) steps, so the last one spawned
+// wakes up first. a step is longer than a tick - threads that are due at the
+// same tick may wake up in any order:
+void sleeper()
+{
+    int tid = uthread_get_tid();
+    int usec = (NUM_SLEEPERS + 1 - tid) * STEP_USEC;
+    long long start = now_usec();
+    uthread_sleep_usec(usec);
+    if (now_usec() - start < usec)
+    {
+        woke_early = true;
+    }
+    woke_order[num_woke++] = tid;
+    uthread_terminate(tid);
+}
+
+void spinner_sleeper()
+{
+    uthread_sleep_usec(STEP_USEC);
+    spinner_woke = true;
+    uthread_terminate(uthread_get_tid());
+}
+
+void spinner()
+{
+    while (!spinner_woke)
+    {
+        uthread_yield();
+    }
+    uthread_terminate(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 15:   " RESET);
+    fflush(stdout);
+
+    uthread_init(500);
+    if (uthread_sleep_usec(-1) != -1 || uthread_sleep_until(nullptr) != -1)
+    {
+        fail("an invalid sleep was accepted");
+    }
+    struct timespec past = {0, 0};
+    if (uthread_sleep_until(&past))
+    {
+        fail("sleeping until the past failed");
+    }
+
+    for (int i = 0; i < NUM_SLEEPERS; i++)
+    {
+        uthread_spawn(sleeper);
+    }
+    // let them all go to sleep, then try to wake the last one up:
+    uthread_yield();
+    uthread_resume(NUM_SLEEPERS);
+    while (num_woke < NUM_SLEEPERS)
+    {}
+
+    if (woke_early)
+    {
+        fail("a thread woke up before its time");
+    }
+    for (int i = 0; i < NUM_SLEEPERS; i++)
+    {
+        if (woke_order[i] != NUM_SLEEPERS - i)
+        {
+            fail("threads woke up out of order");
+        }
+    }
+
+    // main sleeps while nothing else runs:
+    long long start = now_usec();
+    uthread_sleep_usec(20000);
+    if (now_usec() - start < 20000)
+    {
+        fail("main woke up before its time");
+    }
+
+    // threads that only yield never let the quantum expire:
+    int tids[NUM_SPINNERS + 1];
+    tids[0] = uthread_spawn(spinner_sleeper);
+    for (int i = 1; i <= NUM_SPINNERS; i++)
+    {
+        tids[i] = uthread_spawn(spinner);
+    }
+    start = now_usec();
+    uthread_sync_all(tids, NUM_SPINNERS + 1);
+    if (now_usec() - start > 50 * STEP_USEC)
+    {
+        fail("the sleeper woke up late");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -0,0 +1,91 @@
+/**********************************************
+ * Test 16: idle sleep
+ *
+ * while every thread sleeps or waits for a pipe, the process sleeps too:
+ * it uses almost no CPU time, and wakes up on time.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <ctime>
+#include <unistd.h>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define SLEEP_USEC 100000
+// how late a sleeping thread may wake up, and how much CPU time the process
+// may use meanwhile:
+#define SLACK_USEC 20000
+
+int pipe_fds[2];
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+long long clock_usec(clockid_t clock)
+{
+    struct timespec now;
+    clock_gettime(clock, &now);
+    return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+void writer()
+{
+    uthread_sleep_usec(SLEEP_USEC);
+    uthread_write(pipe_fds[1], "x", 1);
+    uthread_terminate(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 16:   " RESET);
+    fflush(stdout);
+
+    uthread_init(1000);
+    if (pipe(pipe_fds))
+    {
+        fail("creating the pipe failed");
+    }
+
+    // main waits for the pipe, the writer sleeps:
+    long long start = clock_usec(CLOCK_MONOTONIC);
+    long long start_cpu = clock_usec(CLOCK_PROCESS_CPUTIME_ID);
+    uthread_spawn(writer);
+    char c;
+    if (uthread_read(pipe_fds[0], &c, 1) != 1)
+    {
+        fail("reading the pipe failed");
+    }
+    long long elapsed = clock_usec(CLOCK_MONOTONIC) - start;
+    if (elapsed < SLEEP_USEC || elapsed > SLEEP_USEC + SLACK_USEC)
+    {
+        fail("the writer did not wake up on time");
+    }
+    if (clock_usec(CLOCK_PROCESS_CPUTIME_ID) - start_cpu > SLACK_USEC)
+    {
+        fail("the process used the CPU while no thread could run");
+    }
+
+    // main sleeps alone:
+    start = clock_usec(CLOCK_MONOTONIC);
+    start_cpu = clock_usec(CLOCK_PROCESS_CPUTIME_ID);
+    uthread_sleep_usec(SLEEP_USEC);
+    elapsed = clock_usec(CLOCK_MONOTONIC) - start;
+    if (elapsed < SLEEP_USEC || elapsed > SLEEP_USEC + SLACK_USEC)
+    {
+        fail("main did not wake up on time");
+    }
+    if (clock_usec(CLOCK_PROCESS_CPUTIME_ID) - start_cpu > SLACK_USEC)
+    {
+        fail("the process used the CPU while main slept");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
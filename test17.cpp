@@ -0,0 +1,180 @@
+/**********************************************
+ * Test 17: mutexes and condition variables
+ *
+ * workers that are preempted inside a critical section keep a shared
+ * counter consistent, waiters get a mutex in FIFO order, and a producer and
+ * a consumer pass items through a condition variable protected buffer.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_WORKERS 8
+#define ITERATIONS 200
+#define NUM_ITEMS 1000
+#define BUF_SIZE 4
+
+uthread_mutex_t counter_mutex = UTHREAD_MUTEX_INITIALIZER;
+uthread_cond_t all_done = UTHREAD_COND_INITIALIZER;
+volatile int counter = 0;
+int num_done = 0;
+
+uthread_mutex_t order_mutex = UTHREAD_MUTEX_INITIALIZER;
+int order[3];
+volatile int num_ordered = 0;
+
+uthread_mutex_t buf_mutex = UTHREAD_MUTEX_INITIALIZER;
+uthread_cond_t not_empty = UTHREAD_COND_INITIALIZER;
+uthread_cond_t not_full = UTHREAD_COND_INITIALIZER;
+uthread_cond_t all_consumed = UTHREAD_COND_INITIALIZER;
+int items[BUF_SIZE];
+int num_items = 0, head = 0;
+long sum = 0;
+bool consumed = false;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void worker()
+{
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        uthread_mutex_lock(&counter_mutex);
+        int value = counter;
+        // long enough to be preempted here every now and then:
+        for (volatile int j = 0; j < 2000; j++)
+        {}
+        counter = value + 1;
+        uthread_mutex_unlock(&counter_mutex);
+    }
+    uthread_mutex_lock(&counter_mutex);
+    num_done++;
+    uthread_cond_signal(&all_done);
+    uthread_mutex_unlock(&counter_mutex);
+    uthread_terminate(uthread_get_tid());
+}
+
+void orderer()
+{
+    uthread_mutex_lock(&order_mutex);
+    order[num_ordered++] = uthread_get_tid();
+    uthread_mutex_unlock(&order_mutex);
+    uthread_terminate(uthread_get_tid());
+}
+
+void producer()
+{
+    for (int i = 1; i <= NUM_ITEMS; i++)
+    {
+        uthread_mutex_lock(&buf_mutex);
+        while (num_items == BUF_SIZE)
+        {
+            uthread_cond_wait(&not_full, &buf_mutex);
+        }
+        items[(head + num_items++) % BUF_SIZE] = i;
+        uthread_cond_signal(&not_empty);
+        uthread_mutex_unlock(&buf_mutex);
+    }
+    uthread_terminate(uthread_get_tid());
+}
+
+void consumer()
+{
+    for (int i = 0; i < NUM_ITEMS; i++)
+    {
+        uthread_mutex_lock(&buf_mutex);
+        while (num_items == 0)
+        {
+            uthread_cond_wait(&not_empty, &buf_mutex);
+        }
+        sum += items[head];
+        head = (head + 1) % BUF_SIZE;
+        num_items--;
+        uthread_cond_signal(&not_full);
+        uthread_mutex_unlock(&buf_mutex);
+    }
+    uthread_mutex_lock(&buf_mutex);
+    consumed = true;
+    uthread_cond_signal(&all_consumed);
+    uthread_mutex_unlock(&buf_mutex);
+    uthread_terminate(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 17:   " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+
+    // misuse is reported:
+    if (uthread_mutex_unlock(&counter_mutex) != -1)
+    {
+        fail("a mutex that is not held was unlocked");
+    }
+    uthread_mutex_lock(&counter_mutex);
+    if (uthread_mutex_lock(&counter_mutex) != -1 ||
+        uthread_mutex_trylock(&counter_mutex) != -1)
+    {
+        fail("a held mutex was locked again");
+    }
+    uthread_mutex_unlock(&counter_mutex);
+
+    for (int i = 0; i < NUM_WORKERS; i++)
+    {
+        uthread_spawn(worker);
+    }
+    // main waits without spinning, which would take whole quantums from the
+    // threads it waits for:
+    uthread_mutex_lock(&counter_mutex);
+    while (num_done < NUM_WORKERS)
+    {
+        uthread_cond_wait(&all_done, &counter_mutex);
+    }
+    uthread_mutex_unlock(&counter_mutex);
+    if (counter != NUM_WORKERS * ITERATIONS)
+    {
+        fail("the counter is inconsistent");
+    }
+
+    // the waiters queue up in the order they run:
+    uthread_mutex_lock(&order_mutex);
+    int first = uthread_spawn(orderer);
+    uthread_spawn(orderer);
+    uthread_spawn(orderer);
+    uthread_yield();
+    uthread_mutex_unlock(&order_mutex);
+    while (num_ordered < 3)
+    {}
+    for (int i = 0; i < 3; i++)
+    {
+        if (order[i] != first + i)
+        {
+            fail("the mutex was not handed off in FIFO order");
+        }
+    }
+
+    uthread_spawn(producer);
+    uthread_spawn(consumer);
+    uthread_mutex_lock(&buf_mutex);
+    while (!consumed)
+    {
+        uthread_cond_wait(&all_consumed, &buf_mutex);
+    }
+    uthread_mutex_unlock(&buf_mutex);
+    if (sum != (long)NUM_ITEMS * (NUM_ITEMS + 1) / 2)
+    {
+        fail("items were lost between the producer and the consumer");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
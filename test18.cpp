@@ -0,0 +1,189 @@
+/**********************************************
+ * Test 18: channels
+ *
+ * producers and consumers pass numbers through a small channel, one at a
+ * time and in batches, until it is closed. a single sender's numbers arrive
+ * in order, full and empty channels fail the try_ calls, and a channel with
+ * no capacity passes numbers from hand to hand.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cerrno>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_PRODUCERS 3
+#define NUM_CONSUMERS 3
+#define NUM_ITEMS 3000
+#define CAPACITY 8
+#define BATCH 5
+
+uthread_chan_t *numbers, *done;
+long sums[NUM_CONSUMERS + 1];
+long counts[NUM_CONSUMERS + 1];
+int next_consumer = 0;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void producer()
+{
+    // odd producers send one at a time, even ones in batches:
+    int batch[BATCH];
+    for (int i = 1; i <= NUM_ITEMS; i += BATCH)
+    {
+        for (int j = 0; j < BATCH; j++)
+        {
+            batch[j] = i + j;
+        }
+        if (uthread_get_tid() % 2)
+        {
+            for (int j = 0; j < BATCH; j++)
+            {
+                uthread_chan_send(numbers, &batch[j]);
+            }
+        }
+        else if (uthread_chan_send_n(numbers, batch, BATCH) != BATCH)
+        {
+            fail("a batch was not sent whole");
+        }
+    }
+    int tid = uthread_get_tid();
+    uthread_chan_send(done, &tid);
+    uthread_terminate(tid);
+}
+
+void consumer()
+{
+    int me = next_consumer++;
+    int batch[BATCH];
+    ssize_t num;
+    while ((num = uthread_chan_recv_n(numbers, batch, BATCH)) > 0)
+    {
+        for (int j = 0; j < num; j++)
+        {
+            sums[me] += batch[j];
+        }
+        counts[me] += num;
+    }
+    if (errno != EPIPE)
+    {
+        fail("receiving failed before the channel was closed");
+    }
+    int tid = uthread_get_tid();
+    uthread_chan_send(done, &tid);
+    uthread_terminate(tid);
+}
+
+void ordered_sender()
+{
+    for (int i = 0; i < NUM_ITEMS; i++)
+    {
+        uthread_chan_send(numbers, &i);
+    }
+    uthread_terminate(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 18:   " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+    numbers = uthread_chan_create(sizeof(int), CAPACITY);
+    done = uthread_chan_create(sizeof(int), NUM_PRODUCERS + NUM_CONSUMERS);
+
+    // full and empty channels:
+    int n = 0;
+    if (uthread_chan_try_recv(numbers, &n) != -1 || errno != EAGAIN)
+    {
+        fail("an empty channel was received from");
+    }
+    for (int i = 0; i < CAPACITY; i++)
+    {
+        uthread_chan_try_send(numbers, &i);
+    }
+    if (uthread_chan_try_send(numbers, &n) != -1 || errno != EAGAIN)
+    {
+        fail("a full channel was sent to");
+    }
+    for (int i = 0; i < CAPACITY; i++)
+    {
+        if (uthread_chan_try_recv(numbers, &n) || n != i)
+        {
+            fail("the buffered numbers were not received in order");
+        }
+    }
+
+    // a single sender's numbers arrive in order:
+    uthread_spawn(ordered_sender);
+    for (int i = 0; i < NUM_ITEMS; i++)
+    {
+        if (uthread_chan_recv(numbers, &n) || n != i)
+        {
+            fail("the numbers were not received in order");
+        }
+    }
+
+    // many senders and receivers, until the channel is closed:
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        uthread_spawn(consumer);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        uthread_spawn(producer);
+    }
+    for (int i = 0; i < NUM_PRODUCERS; i++)
+    {
+        uthread_chan_recv(done, &n);
+    }
+    uthread_chan_close(numbers);
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        uthread_chan_recv(done, &n);
+    }
+    long sum = 0, count = 0;
+    for (int i = 0; i < NUM_CONSUMERS; i++)
+    {
+        sum += sums[i];
+        count += counts[i];
+    }
+    if (count != (long)NUM_PRODUCERS * NUM_ITEMS ||
+        sum != (long)NUM_PRODUCERS * NUM_ITEMS * (NUM_ITEMS + 1) / 2)
+    {
+        fail("numbers were lost in the channel");
+    }
+    if (uthread_chan_send(numbers, &n) != -1 || errno != EPIPE)
+    {
+        fail("a closed channel was sent to");
+    }
+    uthread_chan_destroy(numbers);
+
+    // no capacity - the sender waits for the receiver:
+    numbers = uthread_chan_create(sizeof(int), 0);
+    if (uthread_chan_try_send(numbers, &n) != -1 || errno != EAGAIN)
+    {
+        fail("a channel with no capacity buffered a number");
+    }
+    uthread_spawn(ordered_sender);
+    for (int i = 0; i < NUM_ITEMS; i++)
+    {
+        if (uthread_chan_recv(numbers, &n) || n != i)
+        {
+            fail("the numbers were not passed in order");
+        }
+    }
+    uthread_chan_destroy(numbers);
+    uthread_chan_destroy(done);
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
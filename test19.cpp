@@ -0,0 +1,157 @@
+/**********************************************
+ * Test 19: select
+ *
+ * a gateway thread waits on two channels, a pipe and the termination of a
+ * child at once, and wakes up for each of them in the order they happen. its
+ * other registrations are gone when it wakes up, ready cases are taken in
+ * order, closed channels fail their cases, and invalid IDs fail the select.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cerrno>
+#include <unistd.h>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define STEP_USEC 20000
+
+// the cases of the gateway:
+#define FIRST_CHAN 0
+#define SECOND_CHAN 1
+#define PIPE 2
+#define CHILD 3
+
+uthread_chan_t *first_chan, *second_chan;
+int pipe_fds[2];
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void second_sender()
+{
+    uthread_sleep_usec(STEP_USEC);
+    int n = 2;
+    uthread_chan_send(second_chan, &n);
+    uthread_terminate(uthread_get_tid());
+}
+
+void writer()
+{
+    uthread_sleep_usec(2 * STEP_USEC);
+    uthread_write(pipe_fds[1], "x", 1);
+    uthread_terminate(uthread_get_tid());
+}
+
+void child()
+{
+    uthread_sleep_usec(3 * STEP_USEC);
+    uthread_terminate(uthread_get_tid());
+}
+
+void receiver()
+{
+    int n;
+    uthread_chan_recv(first_chan, &n);
+    uthread_terminate(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 19:   " RESET);
+    fflush(stdout);
+
+    uthread_init(1000);
+    // no capacity - a send succeeds only if a receiver waits:
+    first_chan = uthread_chan_create(sizeof(int), 0);
+    second_chan = uthread_chan_create(sizeof(int), 0);
+    if (pipe(pipe_fds))
+    {
+        fail("creating the pipe failed");
+    }
+
+    uthread_select_case_t cases[4] = {};
+    cases[FIRST_CHAN].kind = UTHREAD_SELECT_RECV;
+    cases[FIRST_CHAN].chan = first_chan;
+    int first_n = 0, second_n = 0;
+    cases[FIRST_CHAN].elem = &first_n;
+    cases[SECOND_CHAN].kind = UTHREAD_SELECT_RECV;
+    cases[SECOND_CHAN].chan = second_chan;
+    cases[SECOND_CHAN].elem = &second_n;
+    cases[PIPE].kind = UTHREAD_SELECT_READ;
+    cases[PIPE].fd = pipe_fds[0];
+    cases[CHILD].kind = UTHREAD_SELECT_EXIT;
+    cases[CHILD].tid = uthread_spawn(child);
+    uthread_spawn(second_sender);
+    uthread_spawn(writer);
+
+    // the events wake the gateway up in the order they happen:
+    if (uthread_select(cases, 4) != SECOND_CHAN || second_n != 2)
+    {
+        fail("the second channel did not wake the gateway up");
+    }
+    int n = 1;
+    if (uthread_chan_try_send(first_chan, &n) != -1 || errno != EAGAIN)
+    {
+        fail("the gateway still waited for the first channel");
+    }
+    if (uthread_select(cases, 4) != PIPE)
+    {
+        fail("the pipe did not wake the gateway up");
+    }
+    char c;
+    uthread_read(pipe_fds[0], &c, 1);
+    if (uthread_select(cases, 4) != CHILD)
+    {
+        fail("the child's termination did not wake the gateway up");
+    }
+    // the child is gone, so its case is ready right away:
+    if (uthread_select(cases, 4) != CHILD)
+    {
+        fail("a terminated child was waited for");
+    }
+
+    // sending, and the first of two ready cases is taken:
+    uthread_spawn(receiver);
+    uthread_yield();
+    cases[FIRST_CHAN].kind = UTHREAD_SELECT_SEND;
+    first_n = 1;
+    uthread_write(pipe_fds[1], "x", 1);
+    if (uthread_select(cases, 3) != FIRST_CHAN)
+    {
+        fail("the first ready case was not taken");
+    }
+    if (uthread_select(cases, 3) != PIPE)
+    {
+        fail("the pipe was not readable");
+    }
+    uthread_read(pipe_fds[0], &c, 1);
+
+    // a closed channel fails its case:
+    uthread_chan_close(second_chan);
+    if (uthread_select(cases, 3) != SECOND_CHAN ||
+        cases[SECOND_CHAN].error != EPIPE)
+    {
+        fail("a closed channel did not fail its case");
+    }
+
+    // the ID of a thread to wait for has to be valid:
+    int invalid_tids[] = {-1, 0, 1 << 30};
+    for (int tid : invalid_tids)
+    {
+        cases[CHILD].tid = tid;
+        if (uthread_select(&cases[CHILD], 1) != -1)
+        {
+            fail("an invalid ID was waited for");
+        }
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
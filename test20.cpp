@@ -0,0 +1,173 @@
+/**********************************************
+ * Test 20: sync_all / sync_any
+ *
+ * a merge tree of threads joins its children with uthread_sync_all, every
+ * thread that syncs to the same thread is woken up, uthread_sync_any returns
+ * the first thread to terminate, and terminated waiters are forgotten.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_LEAVES 8
+#define CHUNK 64
+#define NUM_WAITERS 10
+#define STEP_USEC 20000
+
+int numbers[NUM_LEAVES * CHUNK], merged[NUM_LEAVES * CHUNK];
+// the range of numbers every thread sorts:
+int range_start[MAX_THREAD_NUM], range_end[MAX_THREAD_NUM];
+int target, num_woken = 0;
+// held while a parent sets the ranges of its children:
+uthread_mutex_t tree_mutex = UTHREAD_MUTEX_INITIALIZER;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void sort_range()
+{
+    uthread_mutex_lock(&tree_mutex);
+    uthread_mutex_unlock(&tree_mutex);
+    int start = range_start[uthread_get_tid()];
+    int end = range_end[uthread_get_tid()];
+    if (end - start > CHUNK)
+    {
+        // the two halves are sorted by children, and merged:
+        int middle = (start + end) / 2;
+        int children[2];
+        uthread_mutex_lock(&tree_mutex);
+        for (int i = 0; i < 2; i++)
+        {
+            children[i] = uthread_spawn(sort_range);
+            range_start[children[i]] = i ? middle : start;
+            range_end[children[i]] = i ? end : middle;
+        }
+        uthread_mutex_unlock(&tree_mutex);
+        if (uthread_sync_all(children, 2))
+        {
+            fail("joining the children failed");
+        }
+        int i = start, j = middle, k = start;
+        while (i < middle || j < end)
+        {
+            merged[k++] = (j == end || (i < middle && numbers[i] <= numbers[j]))
+                          ? numbers[i++] : numbers[j++];
+        }
+        for (k = start; k < end; k++)
+        {
+            numbers[k] = merged[k];
+        }
+    }
+    else
+    {
+        for (int i = start + 1; i < end; i++)
+        {
+            for (int j = i; j > start && numbers[j - 1] > numbers[j]; j--)
+            {
+                int tmp = numbers[j];
+                numbers[j] = numbers[j - 1];
+                numbers[j - 1] = tmp;
+            }
+        }
+    }
+    uthread_terminate(uthread_get_tid());
+}
+
+void sleeper()
+{
+    uthread_sleep_usec(uthread_get_tid() * STEP_USEC);
+    uthread_terminate(uthread_get_tid());
+}
+
+void waiter()
+{
+    uthread_sync(target);
+    num_woken++;
+    uthread_terminate(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 20:   " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+
+    // the merge tree:
+    srand(20);
+    for (int i = 0; i < NUM_LEAVES * CHUNK; i++)
+    {
+        numbers[i] = rand();
+    }
+    uthread_mutex_lock(&tree_mutex);
+    int root = uthread_spawn(sort_range);
+    range_start[root] = 0;
+    range_end[root] = NUM_LEAVES * CHUNK;
+    uthread_mutex_unlock(&tree_mutex);
+    uthread_sync_all(&root, 1);
+    for (int i = 1; i < NUM_LEAVES * CHUNK; i++)
+    {
+        if (numbers[i - 1] > numbers[i])
+        {
+            fail("the merge tree did not sort the numbers");
+        }
+    }
+
+    // every waiter of a thread is woken up:
+    target = uthread_spawn(sleeper);
+    int waiters[NUM_WAITERS];
+    for (int i = 0; i < NUM_WAITERS; i++)
+    {
+        waiters[i] = uthread_spawn(waiter);
+    }
+    uthread_sync_all(waiters, NUM_WAITERS);
+    if (num_woken != NUM_WAITERS)
+    {
+        fail("not all the waiters were woken up");
+    }
+
+    // the first sleeper wakes up first:
+    int sleepers[3];
+    for (int i = 0; i < 3; i++)
+    {
+        sleepers[i] = uthread_spawn(sleeper);
+    }
+    if (uthread_sync_any(sleepers, 3) != sleepers[0])
+    {
+        fail("sync_any did not return the first thread to terminate");
+    }
+    // the ones that terminated are not waited for:
+    if (uthread_sync_any(sleepers, 3) != sleepers[0])
+    {
+        fail("a terminated thread was waited for");
+    }
+    uthread_sync_all(sleepers, 3);
+
+    // a terminated waiter is forgotten by the threads it waited for:
+    target = uthread_spawn(sleeper);
+    int forgotten = uthread_spawn(waiter);
+    uthread_yield();
+    uthread_terminate(forgotten);
+    uthread_sync_all(&target, 1);
+    if (num_woken != NUM_WAITERS)
+    {
+        fail("a terminated waiter was woken up");
+    }
+
+    if (uthread_sync_all(nullptr, 1) != -1 || uthread_sync_any(&root, 0) != -1)
+    {
+        fail("invalid IDs were synced to");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -0,0 +1,119 @@
+/**********************************************
+ * Test 21: task pool and futures
+ *
+ * many small tasks are submitted to a pool of a few workers, and their
+ * results are taken from their futures, whether the task has run already or
+ * not. the pool runs the queued tasks before it is destroyed, and can be
+ * created again.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstdint>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_WORKERS 4
+#define NUM_TASKS 2000
+#define STEP_USEC 20000
+
+int num_run = 0;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void *square(void *arg)
+{
+    intptr_t n = (intptr_t)arg;
+    num_run++;
+    return (void *)(n * n);
+}
+
+void *slow_square(void *arg)
+{
+    uthread_sleep_usec(STEP_USEC);
+    return square(arg);
+}
+
+int main()
+{
+    printf(GRN "Test 21:   " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+    if (uthread_submit(square, nullptr) != nullptr)
+    {
+        fail("a task was submitted with no pool");
+    }
+    if (uthread_pool_create(NUM_WORKERS) || uthread_pool_create(NUM_WORKERS) != -1)
+    {
+        fail("the pool was not created once");
+    }
+
+    // many tasks, taken in the order they were submitted:
+    static uthread_future_t *futures[NUM_TASKS];
+    for (int round = 0; round < 2; round++)
+    {
+        for (intptr_t i = 0; i < NUM_TASKS; i++)
+        {
+            futures[i] = uthread_submit(square, (void *)i);
+        }
+        for (intptr_t i = 0; i < NUM_TASKS; i++)
+        {
+            void *result;
+            if (uthread_future_get(futures[i], &result) ||
+                (intptr_t)result != i * i)
+            {
+                fail("a task returned a wrong result");
+            }
+        }
+    }
+
+    // the result of a task that has not run yet is waited for:
+    uthread_future_t *future = uthread_submit(slow_square, (void *)7);
+    void *result;
+    if (uthread_future_get(future, &result) || (intptr_t)result != 49)
+    {
+        fail("a blocked getter did not get the result");
+    }
+
+    // destroying the pool runs the queued tasks:
+    num_run = 0;
+    for (intptr_t i = 0; i < NUM_WORKERS * 2; i++)
+    {
+        futures[i] = uthread_submit(slow_square, (void *)i);
+    }
+    if (uthread_pool_destroy() || num_run != NUM_WORKERS * 2)
+    {
+        fail("the queued tasks did not run before the pool was destroyed");
+    }
+    for (int i = 0; i < NUM_WORKERS * 2; i++)
+    {
+        uthread_future_get(futures[i], nullptr);
+    }
+    if (uthread_pool_destroy() != -1)
+    {
+        fail("a destroyed pool was destroyed");
+    }
+
+    // and a new pool can be created:
+    if (uthread_pool_create(1))
+    {
+        fail("the pool was not created again");
+    }
+    future = uthread_submit(square, (void *)3);
+    if (uthread_future_get(future, &result) || (intptr_t)result != 9)
+    {
+        fail("the new pool did not run a task");
+    }
+    uthread_pool_destroy();
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
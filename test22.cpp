@@ -0,0 +1,183 @@
+/**********************************************
+ * Test 22: spawning with arguments and closures
+ *
+ * threads get their state through uthread_spawn_arg and through lambdas that
+ * capture it, small and large, instead of through globals. threads that
+ * return from their entry point are terminated, and what their closures
+ * captured is destroyed once, when they return or are terminated. captures
+ * whose move constructors and destructors call the library are moved in and
+ * destroyed like any other, and can be preempted meanwhile.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_THREADS 20
+#define BIG_SIZE 32
+
+int num_destroyed = 0, num_calls = 0;
+bool started = false;
+uthread_mutex_t mutex = UTHREAD_MUTEX_INITIALIZER;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+// counts its destructions, but not the ones of moved-from copies:
+struct Tracker
+{
+    bool live;
+    Tracker() : live(true) {}
+    Tracker(const Tracker &other) : live(other.live) {}
+    Tracker(Tracker &&other) : live(other.live) { other.live = false; }
+    ~Tracker()
+    {
+        if (live)
+        {
+            num_destroyed++;
+        }
+    }
+};
+
+// returns once the running thread was preempted, which it is not in the
+// library's critical sections:
+void wait_for_preemption()
+{
+    int quantums = uthread_get_total_quantums();
+    while (uthread_get_total_quantums() == quantums)
+    {
+    }
+}
+
+// calls the library when it is moved or destroyed:
+struct Caller
+{
+    bool live;
+    Caller() : live(true) {}
+    Caller(const Caller &other) : live(other.live) {}
+    Caller(Caller &&other) : live(other.live)
+    {
+        other.live = false;
+        wait_for_preemption();
+        uthread_yield();
+    }
+    ~Caller()
+    {
+        if (live)
+        {
+            wait_for_preemption();
+            uthread_mutex_lock(&mutex);
+            uthread_yield();
+            num_calls++;
+            uthread_mutex_unlock(&mutex);
+        }
+    }
+};
+
+void add_one(void *arg)
+{
+    (*(int *)arg)++;
+}
+
+int main()
+{
+    printf(GRN "Test 22:   " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+
+    // an argument per thread, and threads that return:
+    int counters[NUM_THREADS] = {};
+    int tids[NUM_THREADS];
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        tids[i] = uthread_spawn_arg(add_one, &counters[i]);
+    }
+    uthread_sync_all(tids, NUM_THREADS);
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        if (counters[i] != 1 || uthread_get_quantums(tids[i]) != -1)
+        {
+            fail("a thread did not run once with its argument");
+        }
+    }
+
+    // small closures are kept in the thread, and large ones on the heap:
+    int sums[2] = {};
+    long big[BIG_SIZE];
+    for (int i = 0; i < BIG_SIZE; i++)
+    {
+        big[i] = i;
+    }
+    int *sum = &sums[0];
+    tids[0] = uthread_spawn([sum]() { *sum = 42; });
+    sum = &sums[1];
+    tids[1] = uthread_spawn([sum, big]() {
+        for (int i = 0; i < BIG_SIZE; i++)
+        {
+            *sum += (int)big[i];
+        }
+    });
+    uthread_sync_all(tids, 2);
+    if (sums[0] != 42 || sums[1] != BIG_SIZE * (BIG_SIZE - 1) / 2)
+    {
+        fail("a closure did not run with what it captured");
+    }
+
+    // captures are destroyed when a thread returns, or is terminated:
+    Tracker returned, terminated;
+    int tid = uthread_spawn([returned]() {});
+    uthread_sync(tid);
+    if (num_destroyed != 1)
+    {
+        fail("the captures of a returned thread were not destroyed");
+    }
+    tid = uthread_spawn([terminated]() { uthread_block(uthread_get_tid()); });
+    uthread_yield();
+    uthread_terminate(tid);
+    if (num_destroyed != 2)
+    {
+        fail("the captures of a terminated thread were not destroyed");
+    }
+
+    // and the library is called while they are moved in and destroyed, by
+    // threads that return, terminate themselves or are terminated. they
+    // wait until all are spawned, since the spawner switches meanwhile:
+    Caller caller;
+    int tids_calling[3];
+    tids_calling[0] = uthread_spawn([caller]() {
+        while (!started)
+        {
+            uthread_yield();
+        }
+    });
+    tids_calling[1] = uthread_spawn([caller]() {
+        while (!started)
+        {
+            uthread_yield();
+        }
+        uthread_terminate(uthread_get_tid());
+    });
+    tids_calling[2] = uthread_spawn([caller]() {
+        uthread_block(uthread_get_tid());
+    });
+    started = true;
+    uthread_sync_all(tids_calling, 2);
+    uthread_terminate(tids_calling[2]);
+    uthread_mutex_lock(&mutex);
+    if (num_calls != 3)
+    {
+        fail("the captures that call the library were not destroyed");
+    }
+    uthread_mutex_unlock(&mutex);
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
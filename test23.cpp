@@ -0,0 +1,134 @@
+/**********************************************
+ * Test 23: returning from the entry point
+ *
+ * short-lived threads return from their entry point instead of terminating
+ * themselves, over and over, and a chain of threads that each spawn the
+ * next one and return. the threads synced to them are woken up, their IDs
+ * are reused, and the threads that are left keep running. the thread that
+ * runs after one that returned gets a full quantum of its own.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <ctime>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_ROUNDS 5000
+#define CHAIN_LENGTH 1000
+#define QUANTUM_USECS 20000
+// of the quantum, spent by the thread that returns:
+#define SPENT_PERCENT 80
+
+int num_run = 0, chain_left = CHAIN_LENGTH;
+uthread_mutex_t chain_mutex = UTHREAD_MUTEX_INITIALIZER;
+uthread_cond_t chain_done = UTHREAD_COND_INITIALIZER;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void returner()
+{
+    num_run++;
+}
+
+/**
+ * @return the CPU time of the kernel thread that runs the threads, in
+ * micro-seconds.
+ */
+long cpu_usec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+long successor_usec = 0;
+
+// starts a quantum once the main thread waits for it:
+void spender()
+{
+    long start = cpu_usec();
+    while (cpu_usec() - start < QUANTUM_USECS * SPENT_PERCENT / 100)
+    {
+    }
+}
+
+// runs right after the spender returned, until its quantum ends:
+void successor()
+{
+    int quantums = uthread_get_quantums(uthread_get_tid());
+    long start = cpu_usec();
+    while (uthread_get_quantums(uthread_get_tid()) == quantums)
+    {
+    }
+    successor_usec = cpu_usec() - start;
+}
+
+void chain_link()
+{
+    if (--chain_left)
+    {
+        if (uthread_spawn(chain_link) == -1)
+        {
+            fail("the next link was not spawned");
+        }
+        return;
+    }
+    uthread_mutex_lock(&chain_mutex);
+    uthread_cond_signal(&chain_done);
+    uthread_mutex_unlock(&chain_mutex);
+}
+
+int main()
+{
+    printf(GRN "Test 23:   " RESET);
+    fflush(stdout);
+
+    uthread_init(QUANTUM_USECS);
+
+    // the ID of a thread that returned is free again:
+    int first = uthread_spawn(returner);
+    uthread_sync(first);
+    for (int i = 0; i < NUM_ROUNDS; i++)
+    {
+        int tid = uthread_spawn(returner);
+        if (tid != first)
+        {
+            fail("the ID of a returned thread was not reused");
+        }
+        uthread_sync(tid);
+    }
+    if (num_run != NUM_ROUNDS + 1)
+    {
+        fail("not every thread ran once");
+    }
+
+    // a chain of threads, each of which is gone before the next one runs:
+    uthread_mutex_lock(&chain_mutex);
+    uthread_spawn(chain_link);
+    while (chain_left)
+    {
+        uthread_cond_wait(&chain_done, &chain_mutex);
+    }
+    uthread_mutex_unlock(&chain_mutex);
+
+    // the rest of a returned thread's quantum is not passed on:
+    int tids[2];
+    tids[0] = uthread_spawn(spender);
+    tids[1] = uthread_spawn(successor);
+    uthread_sync_all(tids, 2);
+    if (successor_usec < QUANTUM_USECS / 2)
+    {
+        fail("the next thread got the rest of a returned thread's quantum");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -0,0 +1,182 @@
+/**********************************************
+ * Test 24: thread-local storage keys
+ *
+ * threads keep their state in keys instead of in global tables indexed by
+ * their IDs, and see only their own values across switches. the destructors
+ * of the keys are called with the values of threads that return or are
+ * terminated, and new and recycled threads start with no values. a destructor
+ * that switches threads does not let the terminated thread run again.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstdint>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_THREADS 20
+#define NUM_STEPS 1000
+#define NUM_YIELDS 5
+
+uthread_key_t counter_key, plain_key, yielding_key;
+int num_destroyed = 0;
+long destroyed_sum = 0;
+int num_worked = 0, num_yielding_destroyed = 0;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void destroy_counter(void *value)
+{
+    num_destroyed++;
+    destroyed_sum += *(long *)value;
+    delete (long *)value;
+}
+
+void counter()
+{
+    if (uthread_getspecific(counter_key) || uthread_getspecific(plain_key))
+    {
+        fail("a new thread had values");
+    }
+    uthread_setspecific(counter_key, new long(0));
+    uthread_setspecific(plain_key, (void *)(intptr_t)uthread_get_tid());
+    for (int i = 0; i < NUM_STEPS; i++)
+    {
+        (*(long *)uthread_getspecific(counter_key))++;
+        if (i % 100 == 0)
+        {
+            uthread_yield();
+        }
+        if ((intptr_t)uthread_getspecific(plain_key) != uthread_get_tid())
+        {
+            fail("a thread saw the value of another thread");
+        }
+    }
+}
+
+// switches threads while the thread whose value it destroys is terminated:
+void destroy_yielding(void *)
+{
+    num_yielding_destroyed++;
+    int worked = num_worked;
+    for (int i = 0; i < NUM_YIELDS; i++)
+    {
+        uthread_yield();
+    }
+    if (num_worked != worked)
+    {
+        fail("a terminated thread ran while its value was destroyed");
+    }
+}
+
+void worker()
+{
+    uthread_setspecific(yielding_key, &num_worked);
+    while (true)
+    {
+        num_worked++;
+        uthread_yield();
+    }
+}
+
+bool holder_saw_stale = true;
+
+// keeps a value of the plain key while it is deleted and created again:
+void holder()
+{
+    uthread_setspecific(plain_key, &holder_saw_stale);
+    uthread_block(uthread_get_tid());
+    holder_saw_stale = uthread_getspecific(plain_key) != nullptr;
+}
+
+void blocker()
+{
+    uthread_setspecific(counter_key, new long(1));
+    uthread_block(uthread_get_tid());
+}
+
+int main()
+{
+    printf(GRN "Test 24:   " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+    if (uthread_key_create(&counter_key, destroy_counter) ||
+        uthread_key_create(&plain_key, nullptr) ||
+        uthread_key_create(&yielding_key, destroy_yielding))
+    {
+        fail("creating the keys failed");
+    }
+
+    // every thread counts in its own value, which is destroyed when it
+    // returns. the second round runs on recycled threads:
+    int tids[NUM_THREADS];
+    for (int round = 1; round <= 2; round++)
+    {
+        for (int i = 0; i < NUM_THREADS; i++)
+        {
+            tids[i] = uthread_spawn(counter);
+        }
+        uthread_sync_all(tids, NUM_THREADS);
+        if (num_destroyed != round * NUM_THREADS ||
+            destroyed_sum != (long)round * NUM_THREADS * NUM_STEPS)
+        {
+            fail("the values of returned threads were not destroyed");
+        }
+    }
+
+    // and when another thread terminates it:
+    int tid = uthread_spawn(blocker);
+    uthread_yield();
+    uthread_terminate(tid);
+    if (num_destroyed != 2 * NUM_THREADS + 1)
+    {
+        fail("the value of a terminated thread was not destroyed");
+    }
+
+    // a destructor that yields, while the terminated thread is ready:
+    tid = uthread_spawn(worker);
+    uthread_yield();
+    if (uthread_terminate(tid) || num_yielding_destroyed != 1 ||
+        uthread_get_quantums(tid) != -1)
+    {
+        fail("a thread was not terminated by a yielding destructor");
+    }
+
+    // a deleted key is created again with no values, in any thread:
+    uthread_setspecific(plain_key, &tid);
+    tid = uthread_spawn(holder);
+    uthread_yield();
+    uthread_key_t key;
+    if (uthread_key_delete(plain_key) || uthread_key_create(&key, nullptr) ||
+        key != plain_key || uthread_getspecific(key))
+    {
+        fail("a recreated key kept its values");
+    }
+    uthread_resume(tid);
+    uthread_sync(tid);
+    if (holder_saw_stale)
+    {
+        fail("a recreated key kept the value of another thread");
+    }
+
+    // invalid keys:
+    while (uthread_key_create(&key, nullptr) == 0)
+    {
+    }
+    if (uthread_setspecific(UTHREAD_KEYS_MAX, &tid) != -1 ||
+        uthread_getspecific(-1) != nullptr)
+    {
+        fail("an invalid key was used");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -0,0 +1,112 @@
+/**********************************************
+ * Test 256: per-thread stack sizes
+ *
+ * a thread spawned with a 256 KiB stack recurses deep enough to overflow
+ * the default stack, while a thread with an 8 KiB stack runs alongside it.
+ * a stack that cannot be mapped fails the spawn, and its ID is free again.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <sys/resource.h>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define DEPTH 1000
+// far below a stack of INT_MAX bytes:
+#define ADDRESS_SPACE_LIMIT (1L << 30)
+#define RUN 0
+#define DONE 1
+
+char thread_status[3];
+int depth_reached = 0;
+
+void halt()
+{
+    while (true)
+    {}
+}
+
+// about 200 bytes of stack per call
+int recurse(int depth)
+{
+    volatile char frame[128];
+    memset((char*)frame, depth, sizeof(frame));
+    if (depth == DEPTH)
+    {
+        return frame[0];
+    }
+    depth_reached = depth;
+    return recurse(depth + 1) + frame[1] - frame[0];
+}
+
+void deep_thread()
+{
+    recurse(1);
+    thread_status[uthread_get_tid()] = DONE;
+    halt();
+}
+
+void small_thread()
+{
+    thread_status[uthread_get_tid()] = DONE;
+    halt();
+}
+
+int main()
+{
+    printf(GRN "Test 256:  " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+
+    uthread_attr_t attr;
+    attr.stack_size = -1;
+    if (uthread_spawn_ex(small_thread, &attr) != -1)
+    {
+        printf(RED "ERROR - negative stack size was accepted\n" RESET);
+        uthread_terminate(0);
+    }
+
+    // a stack that does not fit in the address space:
+    struct rlimit limit;
+    getrlimit(RLIMIT_AS, &limit);
+    struct rlimit lowered = limit;
+    lowered.rlim_cur = ADDRESS_SPACE_LIMIT;
+    setrlimit(RLIMIT_AS, &lowered);
+    attr.stack_size = INT_MAX;
+    int failed = uthread_spawn_ex(small_thread, &attr);
+    setrlimit(RLIMIT_AS, &limit);
+    if (failed != -1)
+    {
+        printf(RED "ERROR - an unmappable stack was accepted\n" RESET);
+        uthread_terminate(0);
+    }
+
+    attr.stack_size = 256 * 1024;
+    int t1 = uthread_spawn_ex(deep_thread, &attr);
+    attr.stack_size = 8 * 1024;
+    int t2 = uthread_spawn_ex(small_thread, &attr);
+    if (t1 != 1 || t2 != 2)
+    {
+        printf(RED "ERROR - thread spawn failed\n" RESET);
+        uthread_terminate(0);
+    }
+
+    while (thread_status[t1] == RUN || thread_status[t2] == RUN)
+    {}
+
+    if (depth_reached != DEPTH - 1)
+    {
+        printf(RED "ERROR - recursion did not complete\n" RESET);
+        uthread_terminate(0);
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
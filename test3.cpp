@@ -0,0 +1,115 @@
+/**********************************************
+ * Test 3: thread IDs under churn
+ *
+ * threads are spawned and terminated at random, across several words of IDs
+ * and up to the limit. every spawn gets the smallest free ID, a spawn at the
+ * limit fails, and the IDs of terminated threads are free again.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define MAX_THREADS 5000
+#define NUM_STEPS 50000
+// long enough that the main thread is not preempted:
+#define QUANTUM_USECS 100000000
+
+bool used[MAX_THREADS];
+int num_used = 1;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+// the spawned threads stay READY, and never run:
+void never_run()
+{
+    fail("a thread ran");
+}
+
+/**
+ * @return the smallest ID that is not used. Called below the limit.
+ */
+int smallest_free()
+{
+    int tid = 1;
+    while (used[tid])
+    {
+        tid++;
+    }
+    return tid;
+}
+
+void spawn()
+{
+    int expected = smallest_free();
+    if (uthread_spawn(never_run) != expected)
+    {
+        fail("a thread did not get the smallest free ID");
+    }
+    used[expected] = true;
+    num_used++;
+}
+
+int main()
+{
+    printf(GRN "Test 3:    " RESET);
+    fflush(stdout);
+
+    uthread_init_ex(QUANTUM_USECS, MAX_THREADS);
+    used[0] = true;
+    srand(3);
+
+    // grow to the limit and back, terminating at random on the way:
+    for (int step = 0; step < NUM_STEPS; step++)
+    {
+        bool growing = (step / (NUM_STEPS / 4)) % 2 == 0;
+        if (rand() % 4 < (growing ? 3 : 1) && num_used < MAX_THREADS)
+        {
+            spawn();
+            continue;
+        }
+        if (num_used == 1)
+        {
+            continue;
+        }
+        int tid;
+        do
+        {
+            tid = 1 + rand() % (MAX_THREADS - 1);
+        } while (!used[tid]);
+        if (uthread_terminate(tid))
+        {
+            fail("a thread was not terminated");
+        }
+        used[tid] = false;
+        num_used--;
+    }
+
+    // the limit is reached, and the IDs are free once the threads are gone:
+    while (num_used < MAX_THREADS)
+    {
+        spawn();
+    }
+    if (uthread_spawn(never_run) != -1)
+    {
+        fail("a thread was spawned past the limit");
+    }
+    for (int tid = MAX_THREADS - 1; tid > 0; tid--)
+    {
+        uthread_terminate(tid);
+        used[tid] = false;
+    }
+    spawn();
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
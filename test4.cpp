@@ -0,0 +1,133 @@
+/**********************************************
+ * Test 4: blocking and terminating READY threads
+ *
+ * READY threads are blocked and terminated at the front, in the middle and
+ * at the end of the ready queue, among a few threads and among many. the
+ * threads that are left run in the order they were in, blocked threads do
+ * not run, and resumed threads run last.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_FEW 8
+#define NUM_MANY 1000
+// long enough that no thread is preempted:
+#define QUANTUM_USECS 100000000
+
+int run_order[NUM_MANY + NUM_FEW];
+int num_run = 0;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+// runs once per round:
+void logger()
+{
+    while (true)
+    {
+        run_order[num_run++] = uthread_get_tid();
+        uthread_yield();
+    }
+}
+
+/**
+ * Lets every READY thread run once, and checks the order they ran in.
+ * @param order - the expected IDs.
+ * @param num - the number of IDs.
+ */
+void expect_round(const int *order, int num)
+{
+    num_run = 0;
+    uthread_yield();
+    if (num_run != num)
+    {
+        fail("a wrong number of threads ran");
+    }
+    for (int i = 0; i < num; i++)
+    {
+        if (run_order[i] != order[i])
+        {
+            fail("the threads did not run in order");
+        }
+    }
+}
+
+int main()
+{
+    printf(GRN "Test 4:    " RESET);
+    fflush(stdout);
+
+    uthread_init_ex(QUANTUM_USECS, NUM_MANY + 1);
+    for (int i = 0; i < NUM_FEW; i++)
+    {
+        uthread_spawn(logger);
+    }
+    int all[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    expect_round(all, 8);
+
+    // in the middle:
+    uthread_block(3);
+    uthread_terminate(5);
+    uthread_block(6);
+    int middle[] = {1, 2, 4, 7, 8};
+    expect_round(middle, 5);
+    uthread_resume(6);
+    uthread_resume(3);
+    int resumed[] = {1, 2, 4, 7, 8, 6, 3};
+    expect_round(resumed, 7);
+
+    // at the front and at the end:
+    uthread_block(1);
+    uthread_terminate(3);
+    int ends[] = {2, 4, 7, 8, 6};
+    expect_round(ends, 5);
+    uthread_terminate(1);
+    for (int tid : ends)
+    {
+        uthread_terminate(tid);
+    }
+
+    // every other one of many:
+    static int many[NUM_MANY];
+    for (int i = 0; i < NUM_MANY; i++)
+    {
+        many[i] = uthread_spawn(logger);
+    }
+    expect_round(many, NUM_MANY);
+    static int odd[NUM_MANY / 2];
+    for (int i = 0; i < NUM_MANY; i++)
+    {
+        if (i % 2)
+        {
+            odd[i / 2] = many[i];
+        }
+        else
+        {
+            uthread_block(many[i]);
+        }
+    }
+    expect_round(odd, NUM_MANY / 2);
+    for (int i = 0; i < NUM_MANY; i += 2)
+    {
+        uthread_resume(many[i]);
+        uthread_terminate(many[i + 1]);
+    }
+    static int even[NUM_MANY / 2];
+    for (int i = 0; i < NUM_MANY; i += 2)
+    {
+        even[i / 2] = many[i];
+    }
+    expect_round(even, NUM_MANY / 2);
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
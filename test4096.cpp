@@ -0,0 +1,153 @@
+/**********************************************
+ * Test 4096: file I/O through io_uring
+ *
+ * 16 threads write 8 blocks of 4096 bytes each to a file, at offsets of
+ * their own, then read them back. A read completes while other threads
+ * only yield to each other, and a thread with a read in flight is
+ * terminated.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_WORKERS 16
+#define BLOCKS 8
+#define BLOCK_SIZE 4096
+#define RUN 0
+#define DONE 1
+
+int file_fd;
+char thread_status[NUM_WORKERS + 2];
+bool data_ok = true;
+bool yield_done = false;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+void worker()
+{
+    int tid = uthread_get_tid();
+    char block[BLOCK_SIZE];
+    for (int i = 0; i < BLOCKS; i++)
+    {
+        memset(block, tid * BLOCKS + i, sizeof(block));
+        off_t offset = (off_t)((tid - 1) * BLOCKS + i) * BLOCK_SIZE;
+        if (uthread_pwrite(file_fd, block, sizeof(block), offset) != BLOCK_SIZE)
+        {
+            fail("pwrite failed");
+        }
+    }
+    for (int i = 0; i < BLOCKS; i++)
+    {
+        off_t offset = (off_t)((tid - 1) * BLOCKS + i) * BLOCK_SIZE;
+        if (uthread_pread(file_fd, block, sizeof(block), offset) != BLOCK_SIZE)
+        {
+            fail("pread failed");
+        }
+        for (int j = 0; j < BLOCK_SIZE; j++)
+        {
+            if (block[j] != (char)(tid * BLOCKS + i))
+            {
+                data_ok = false;
+            }
+        }
+    }
+    thread_status[tid] = DONE;
+    uthread_terminate(tid);
+}
+
+void yielding_reader()
+{
+    static char block[BLOCK_SIZE];
+    if (uthread_pread(file_fd, block, sizeof(block), 0) != BLOCK_SIZE)
+    {
+        fail("pread failed");
+    }
+    yield_done = true;
+    uthread_terminate(uthread_get_tid());
+}
+
+void yielder()
+{
+    while (!yield_done)
+    {
+        uthread_yield();
+    }
+    uthread_terminate(uthread_get_tid());
+}
+
+void doomed_reader()
+{
+    static char block[BLOCK_SIZE];
+    uthread_pread(file_fd, block, sizeof(block), 0);
+    fail("a terminated thread returned from pread");
+}
+
+int main()
+{
+    printf(GRN "Test 4096: " RESET);
+    fflush(stdout);
+
+    char path[] = "/tmp/uthreads_test4096_XXXXXX";
+    file_fd = mkstemp(path);
+    if (file_fd == -1)
+    {
+        fail("creating the file failed");
+    }
+    unlink(path);
+
+    uthread_init(1000);
+    for (int i = 0; i < NUM_WORKERS; i++)
+    {
+        uthread_spawn(worker);
+    }
+    for (int tid = 1; tid <= NUM_WORKERS; tid++)
+    {
+        while (thread_status[tid] == RUN)
+        {}
+    }
+    if (!data_ok)
+    {
+        fail("read data differs from written data");
+    }
+
+    // threads that only yield never let the quantum expire:
+    int tids[3];
+    tids[0] = uthread_spawn(yielding_reader);
+    tids[1] = uthread_spawn(yielder);
+    tids[2] = uthread_spawn(yielder);
+    uthread_sync_all(tids, 3);
+
+    // errors are reported through errno:
+    char c;
+    if (uthread_pread(-1, &c, 1, 0) != -1 || errno != EBADF)
+    {
+        fail("pread of a bad file descriptor did not fail with EBADF");
+    }
+
+    int tid = uthread_spawn(doomed_reader);
+    uthread_yield();
+    uthread_terminate(tid);
+    int start = uthread_get_total_quantums();
+    while (uthread_get_total_quantums() < start + 5)
+    {}
+    if (uthread_spawn(worker) != tid)
+    {
+        fail("the terminated thread's ID was not reused");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
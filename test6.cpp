@@ -0,0 +1,146 @@
+/**********************************************
+ * Test 6: stack reuse and guard pages
+ *
+ * a thread spawned after another one of the same stack size returned runs on
+ * the same stack, and a thread of another size does not. stacks are only
+ * rounded to whole pages, so a 256 KiB stack does not take twice its size.
+ * a thread that overflows its stack kills the process with SIGSEGV, instead
+ * of writing over memory below it.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <csignal>
+#include <cstdint>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define SMALL_STACK (8 * 1024)
+#define LARGE_STACK (256 * 1024)
+// more than the library keeps for signal handlers, less than a doubling:
+#define MAX_OVERHEAD (64 * 1024)
+
+char *stack_address;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+/**
+ * @return the size of the mapping that contains address, or 0.
+ */
+size_t mapping_size(void *address)
+{
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (!maps)
+    {
+        return 0;
+    }
+    char line[512];
+    size_t size = 0;
+    while (fgets(line, sizeof(line), maps))
+    {
+        uintptr_t start, end;
+        if (sscanf(line, "%lx-%lx", &start, &end) == 2 &&
+            (uintptr_t)address >= start && (uintptr_t)address < end)
+        {
+            size = end - start;
+            break;
+        }
+    }
+    fclose(maps);
+    return size;
+}
+
+void record_stack()
+{
+    char local;
+    stack_address = &local;
+}
+
+int recurse(int depth)
+{
+    volatile char frame[128];
+    memset((char*)frame, depth, sizeof(frame));
+    return recurse(depth + 1) + frame[1];
+}
+
+void overflow()
+{
+    recurse(0);
+}
+
+/**
+ * Spawns record_stack with a stack of stack_size bytes, and waits for it.
+ * @return the address of its local variable.
+ */
+char *run_on_stack(int stack_size)
+{
+    uthread_attr_t attr;
+    attr.stack_size = stack_size;
+    int tid = uthread_spawn_ex(record_stack, &attr);
+    if (tid == -1)
+    {
+        fail("thread spawn failed");
+    }
+    uthread_sync(tid);
+    return stack_address;
+}
+
+int main()
+{
+    printf(GRN "Test 6:    " RESET);
+    fflush(stdout);
+
+    // a thread that overflows its stack is stopped by the guard page:
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        uthread_init(100);
+        uthread_attr_t attr;
+        attr.stack_size = SMALL_STACK;
+        uthread_sync(uthread_spawn_ex(overflow, &attr));
+        _exit(0);
+    }
+    int status;
+    if (pid == -1 || waitpid(pid, &status, 0) != pid ||
+        !WIFSIGNALED(status) || WTERMSIG(status) != SIGSEGV)
+    {
+        printf(RED "ERROR - a stack overflow was not stopped\n" RESET);
+        return 1;
+    }
+
+    uthread_init(100);
+
+    // the stack of a returned thread is reused for the same size only:
+    char *small = run_on_stack(SMALL_STACK);
+    if (run_on_stack(SMALL_STACK) != small)
+    {
+        fail("a cached stack was not reused");
+    }
+    char *large = run_on_stack(LARGE_STACK);
+    if (large == small || run_on_stack(SMALL_STACK) != small ||
+        run_on_stack(LARGE_STACK) != large)
+    {
+        fail("a cached stack was reused for another size");
+    }
+
+    // and is about as large as asked for:
+    size_t small_size = mapping_size(small), large_size = mapping_size(large);
+    if (small_size < SMALL_STACK || small_size > SMALL_STACK + MAX_OVERHEAD ||
+        large_size < LARGE_STACK || large_size > LARGE_STACK + MAX_OVERHEAD)
+    {
+        fail("a stack was not rounded to whole pages");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
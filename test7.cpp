@@ -0,0 +1,103 @@
+/**********************************************
+ * Test 7: preemption in the library's critical sections
+ *
+ * a thread that spends its time in library calls, and never yields, is
+ * still preempted: a quantum that ends inside a call is carried out when
+ * the call returns, instead of being lost. the calls do not block the
+ * timer signal.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <csignal>
+#include <ctime>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_QUANTUMS 50
+// copied in and out of a channel inside the library's critical sections:
+#define ELEM_SIZE (1 << 20)
+// many times what NUM_QUANTUMS quantums take:
+#define TIMEOUT_SECS 5
+
+uthread_chan_t *chan;
+char elem[ELEM_SIZE];
+int spinner_tid;
+bool done = false;
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+/**
+ * @return true if the timer signal is blocked.
+ */
+bool timer_blocked()
+{
+    sigset_t set;
+    sigprocmask(SIG_BLOCK, nullptr, &set);
+    return sigismember(&set, SIGVTALRM);
+}
+
+// runs only when the caller is preempted:
+void spinner()
+{
+    while (!done)
+    {
+    }
+}
+
+// in a critical section for most of its time:
+void caller()
+{
+    time_t deadline = time(nullptr) + TIMEOUT_SECS;
+    while (uthread_get_quantums(spinner_tid) < NUM_QUANTUMS)
+    {
+        if (uthread_chan_try_send(chan, elem) ||
+            uthread_chan_try_recv(chan, elem))
+        {
+            fail("the channel did not pass the element");
+        }
+        if (timer_blocked())
+        {
+            fail("the timer signal was left blocked by a library call");
+        }
+        if (time(nullptr) > deadline)
+        {
+            fail("preemptions inside library calls were lost");
+        }
+    }
+    done = true;
+}
+
+int main()
+{
+    printf(GRN "Test 7:    " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+    chan = uthread_chan_create(ELEM_SIZE, 1);
+    int tids[2];
+    tids[0] = spinner_tid = uthread_spawn(spinner);
+    tids[1] = uthread_spawn(caller);
+    uthread_sync_all(tids, 2);
+    uthread_chan_destroy(chan);
+
+    // every quantum of the spinner started with a preemption of the caller:
+    if (uthread_get_total_quantums() < 2 * NUM_QUANTUMS)
+    {
+        fail("preemptions were not counted");
+    }
+    if (timer_blocked())
+    {
+        fail("the timer signal was left blocked");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
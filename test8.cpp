@@ -0,0 +1,66 @@
+/**********************************************
+ * Test 8: priorities
+ *
+ * three threads of different priorities are spawned in reverse order of
+ * priority, and have to run highest priority first.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_THREADS 4
+
+int run_order[NUM_THREADS];
+int num_ran = 0;
+
+void halt()
+{
+    while (true)
+    {}
+}
+
+void thread()
+{
+    run_order[num_ran++] = uthread_get_tid();
+    uthread_block(uthread_get_tid());
+    halt();
+}
+
+int main()
+{
+    printf(GRN "Test 8:    " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+    if (uthread_set_policy(UTHREAD_POLICY_MLFQ + 1) != -1 ||
+        uthread_set_priority(0, UTHREAD_NUM_PRIORITIES) != -1)
+    {
+        printf(RED "ERROR - invalid argument was accepted\n" RESET);
+        uthread_terminate(0);
+    }
+
+    // main runs below the spawned threads:
+    uthread_set_priority(0, 3);
+    int t1 = uthread_spawn(thread);
+    int t2 = uthread_spawn(thread);
+    int t3 = uthread_spawn(thread);
+    uthread_set_priority(t1, 2);
+    uthread_set_priority(t2, 1);
+
+    while (num_ran < 3)
+    {}
+
+    if (run_order[0] != t3 || run_order[1] != t2 || run_order[2] != t1)
+    {
+        printf(RED "ERROR - threads did not run by priority\n" RESET);
+        uthread_terminate(0);
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
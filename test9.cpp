@@ -0,0 +1,142 @@
+/**********************************************
+ * Test 9: what a context switch keeps
+ *
+ * threads that yield to each other keep the registers a callee preserves,
+ * each with values of its own, and their floating point rounding modes,
+ * across voluntary switches and preemptions.
+ *
+ **********************************************/
+
+#include <cstdio>
+#include <cfenv>
+#include "uthreads.h"
+
+#define GRN "\e[32m"
+#define RED "\x1B[31m"
+#define RESET "\x1B[0m"
+
+#define NUM_THREADS 4
+#define NUM_SWITCHES 1000
+#define NUM_PREEMPTIONS 20
+
+int rounding_modes[NUM_THREADS] = {FE_TONEAREST, FE_UPWARD, FE_DOWNWARD,
+                                   FE_TOWARDZERO};
+int tids[NUM_THREADS];
+
+void fail(const char *msg)
+{
+    printf(RED "ERROR - %s\n" RESET, msg);
+    uthread_terminate(0);
+}
+
+#ifdef __x86_64__
+/**
+ * Sets the callee-saved registers to seed, seed + 1, ..., calls yield, and
+ * checks that they still hold these values.
+ * @return 1 if they do, 0 otherwise.
+ */
+extern "C" long yield_keeping_registers(long seed, int (*yield)());
+asm(".text\n"
+    ".globl yield_keeping_registers\n"
+    ".type yield_keeping_registers, @function\n"
+    "yield_keeping_registers:\n"
+    "    pushq %rbx\n"
+    "    pushq %rbp\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    // the seed, which also aligns the stack for the call:
+    "    pushq %rdi\n"
+    "    movq %rdi, %rbx\n"
+    "    leaq 1(%rdi), %rbp\n"
+    "    leaq 2(%rdi), %r12\n"
+    "    leaq 3(%rdi), %r13\n"
+    "    leaq 4(%rdi), %r14\n"
+    "    leaq 5(%rdi), %r15\n"
+    "    call *%rsi\n"
+    "    popq %rdx\n"
+    "    xorl %eax, %eax\n"
+    "    cmpq %rdx, %rbx\n"
+    "    jne 1f\n"
+    "    incq %rdx\n"
+    "    cmpq %rdx, %rbp\n"
+    "    jne 1f\n"
+    "    incq %rdx\n"
+    "    cmpq %rdx, %r12\n"
+    "    jne 1f\n"
+    "    incq %rdx\n"
+    "    cmpq %rdx, %r13\n"
+    "    jne 1f\n"
+    "    incq %rdx\n"
+    "    cmpq %rdx, %r14\n"
+    "    jne 1f\n"
+    "    incq %rdx\n"
+    "    cmpq %rdx, %r15\n"
+    "    jne 1f\n"
+    "    movl $1, %eax\n"
+    "1:\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbp\n"
+    "    popq %rbx\n"
+    "    ret\n"
+    ".size yield_keeping_registers, .-yield_keeping_registers\n");
+#endif
+
+void switcher()
+{
+    // spawned first, so the IDs are 1 to NUM_THREADS:
+    int index = uthread_get_tid() - 1;
+    int mode = rounding_modes[index];
+    fesetround(mode);
+    for (int i = 0; i < NUM_SWITCHES; i++)
+    {
+#ifdef __x86_64__
+        if (!yield_keeping_registers(((long)index << 32) + i, uthread_yield))
+        {
+            fail("a callee-saved register changed across a switch");
+        }
+#else
+        uthread_yield();
+#endif
+        if (fegetround() != mode)
+        {
+            fail("the rounding mode changed across a switch");
+        }
+    }
+    // and across preemptions:
+    for (int i = 0; i < NUM_PREEMPTIONS; i++)
+    {
+        int quantums = uthread_get_quantums(uthread_get_tid());
+        while (uthread_get_quantums(uthread_get_tid()) == quantums)
+        {
+        }
+        if (fegetround() != mode)
+        {
+            fail("the rounding mode changed across a preemption");
+        }
+    }
+}
+
+int main()
+{
+    printf(GRN "Test 9:    " RESET);
+    fflush(stdout);
+
+    uthread_init(100);
+    for (int i = 0; i < NUM_THREADS; i++)
+    {
+        tids[i] = uthread_spawn(switcher);
+    }
+    uthread_sync_all(tids, NUM_THREADS);
+    if (fegetround() != FE_TONEAREST)
+    {
+        fail("the rounding mode of the main thread changed");
+    }
+
+    printf(GRN "SUCCESS\n" RESET);
+    uthread_terminate(0);
+}
@@ -6,43 +6,156 @@
 // ------------------------------ includes ------------------------------
 
 #include <iostream>
-#include <sys/time.h>
-#include <vector>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/auxv.h>
 #include <algorithm>
 #include <signal.h>
 #include <cassert>
+#include <atomic>
+#include <errno.h>
+#include <poll.h>
+#include <alloca.h>
+#include <new>
+#include <linux/io_uring.h>
 #include "uthreads.h"
 #include "Thread.h"
+#include "IdAllocator.h"
+#include "ThreadList.h"
+#include "ThreadCache.h"
+#include "ThreadTable.h"
+#include "ReadyQueue.h"
+#include "Reactor.h"
+#include "IoRing.h"
+#include "TimerWheel.h"
+#include "WaitQueue.h"
+#include "Channel.h"
+#include "TaskPool.h"
 
 #define ERR_FUNC_FAIL "thread library error: "
 #define ERR_SYS_CALL "system error: "
-#define AFTER_JUMP 2
+// stack space used by the timer handler and the scheduler, besides the
+// signal frame:
+#define HANDLER_STACK_RESERVE 4096
+// the length of a tick of the sleep timers:
+#define TIMER_RESOLUTION_USEC 100
+
+// mutex states:
+#define MUTEX_UNLOCKED 0
+#define MUTEX_LOCKED 1
+// locked, and threads may be waiting for it:
+#define MUTEX_CONTENDED 2
+
+// older glibc versions only expose the thread ID member of sigevent as:
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
 
 //todo:
 // check makefile
 
+/**
+ * The entry point of a thread spawned with uthread_spawn or uthread_spawn_arg:
+ * either f(), or fArg(arg).
+ */
+struct EntryCall
+{
+    void (*f)(void);
+    void (*fArg)(void *);
+    void *arg;
+};
+
 // ------------------------------- globals ------------------------------
 
-static std::vector<Thread*> buf(MAX_THREAD_NUM);
-static std::deque<Thread*> readyBuf;
+static ThreadTable buf(MAX_THREAD_NUM);
+static ReadyQueue readyBuf(buf);
+static IdAllocator ids(MAX_THREAD_NUM);
+static ThreadCache threadCache(THREAD_CACHE_SIZE);
+static Reactor reactor;
+static IoRing ioRing;
+static TimerWheel timers;
+static TaskPool taskPool;
 static int numThreads, currentThreadId, totalQuantumNum;
-sigset_t blockSet;
-bool isReady = true; // state of the currently running thread , before timeHandler is called.
+static int schedulingPolicy = UTHREAD_POLICY_RR;
+
+// critical section state. while a library call is in its critical section the
+// timer handler only records that a preemption is due, and the preemption is
+// carried out when the critical section ends:
+static volatile sig_atomic_t inCriticalSection = 0, preemptionPending = 0;
+
+// the context a terminated thread is switched out into. it is never resumed.
+static Context deadContext;
+// a thread that terminated itself. it is cached by the next thread to run,
+// once its stack is no longer in use.
+static Thread *zombie = nullptr;
+// stack space every thread gets on top of its requested stack size:
+static size_t signalStackReserve;
+// the thread-local storage keys that exist, and their destructors:
+static bool keyCreated[UTHREAD_KEYS_MAX];
+static void (*keyDestructors[UTHREAD_KEYS_MAX])(void *);
+// bumped whenever a key is created, so the values a deleted key left in
+// threads are stale without clearing them:
+static unsigned int keyGenerations[UTHREAD_KEYS_MAX];
+// the values of the keys in the RUNNING thread, and their generations:
+static void **runningSpecific;
+static unsigned int *runningGenerations;
+// when events were last polled, and how often they have to be, in
+// micro-seconds of CLOCK_MONOTONIC:
+static uint64_t lastPollUsec, pollIntervalUsec;
 
 //timer globals:
 struct sigaction sa;
-static struct itimerval timer;
+static timer_t timer;
+static struct itimerspec quantum;
+// set when the timer does not have to be re-armed at the next switch: either
+// it expired (it is periodic, so the next quantum has already started), or the
+// running thread donates the rest of its quantum to the next one:
+static volatile sig_atomic_t keepTimer = 0;
 
 // -------------------------- inner funcs ------------------------------
 
 // declarations so we can keep up with our funcs
 int idValidator(int tid);
 void timeHandler(int sig);
-void scheduler(int sig);
+void scheduler(int state, Thread *next = nullptr);
+void preempt();
 void contextSwitch(int tid);
+void threadLauncher();
+void exitThread();
+void runKeyDestructors(Thread *thread);
+void constructEntryCall(void *storage, void *callable);
+void runEntryCall(void *storage);
+void destroyEntryCall(void *storage);
+int spawnThread(const uthread_closure_ops_t *ops, void *callable,
+                const uthread_attr_t *attr);
+void reapZombie();
+size_t getSignalStackReserve();
 int setTimer(int quantum_usecs);
-void removeFromBuf(std::deque<Thread*> * buffer, int tid);
 void informDependents(int tid);
+int waitForExit(const int *tids, int numTids, bool all);
+int validateSyncTargets(const int *tids, int numTids);
+void wakeUp(Thread *thread);
+void completeIo(Thread *thread, int result);
+void pollEvents();
+void pollEventsIfDue();
+void idle();
+void waitInQueue(uthread_wait_queue_t *queue, void *data);
+void wakeNode(WaitNode *node);
+void cancelNode(WaitNode *node);
+void handOffMutex(uthread_mutex_t *mutex);
+void requeueOnMutex(WaitNode *node);
+ssize_t sendToChannel(uthread_chan_t *chan, const void *elems, size_t count,
+                      bool block);
+ssize_t receiveFromChannel(uthread_chan_t *chan, void *elems, size_t count,
+                           bool block);
+int selectReady(uthread_select_case_t *cases, int numCases);
+void poolWorker();
+uint64_t getMonotonicUsec();
+void expireTimer(TimerNode *node);
+ssize_t ringIo(int opcode, int fd, void *data, size_t count, off_t offset);
+int waitForFd(int fd, int direction);
+ssize_t leaveIoCall(ssize_t ret);
 void mask();
 void unMask();
 int resetTimer();
@@ -56,34 +169,43 @@ int resetTimer();
  */
 void exitLib(int retVal)
 {
-    sigprocmask(SIG_BLOCK, &blockSet, nullptr);
-    for (Thread* thread: buf) {
-        if (thread){
+    mask();
+    readyBuf.clear();
+    threadCache.trim(0);
+    for (int tid = 0; tid < buf.capacity(); tid++) {
+        Thread* thread = buf[tid];
+        // the stack we are running on is released by exit():
+        if (thread && thread->getId() != currentThreadId){
             delete(thread);
         }
     }
-    vector<Thread*> dummy_1;
-    deque<Thread*> dummy_2;
-    buf.swap(dummy_1);
-    readyBuf.swap(dummy_2);
+    buf.clear();
 
     exit(retVal);
     }
 
 
 /**
- * Resets the timer, and updates total quantums and quantums per current
- * thread.
+ * Starts a new quantum: re-arms the timer if the old quantum was cut short,
+ * and updates total quantums and quantums per current thread.
  * @return 0 on success, -1 on failure.
  */
 int resetTimer()
 {
     buf[currentThreadId]->increaseNumQuantums();
-    if (setitimer (ITIMER_VIRTUAL, &timer, nullptr)) {
-        std::cerr << ERR_SYS_CALL << "Resetting the virtual timer has failed.\n";
+    if (!keepTimer && timer_settime(timer, 0, &quantum, nullptr)) {
+        std::cerr << ERR_SYS_CALL << "Resetting the timer has failed.\n";
         exitLib(-1);
     }
+    keepTimer = 0;
     totalQuantumNum++;
+    if (schedulingPolicy == UTHREAD_POLICY_MLFQ &&
+        totalQuantumNum % MLFQ_BOOST_PERIOD == 0) {
+        readyBuf.boost();
+    }
+    // a new quantum has started - a preemption recorded during the old one is
+    // no longer due:
+    preemptionPending = 0;
     return 0;
 }
 
@@ -92,7 +214,7 @@ int resetTimer()
  */
 int idValidator(int tid)
 {
-    if (tid < 0 || tid > MAX_THREAD_NUM || !buf[tid]) {
+    if (tid < 0 || tid >= buf.capacity() || !buf[tid]) {
         return -1;
     }
     return 0;
@@ -106,30 +228,60 @@ int idValidator(int tid)
  */
 void timeHandler(int sig){
     sig++; // to avoid compilation warnings
-    mask();
-    if (isReady){
-        scheduler(READY);
-    } else {
-        scheduler(BLOCKED);
+    keepTimer = 1;
+    if (inCriticalSection) {
+        // the preemption is carried out by unMask():
+        preemptionPending = 1;
+        return;
     }
-    isReady = true;
+    // the interrupted thread may be about to read errno:
+    int savedErrno = errno;
+    mask();
+    preempt();
     unMask();
+    errno = savedErrno;
 
 }
 
 
+/**
+ * Preempts the running thread at the end of its quantum. Under MLFQ, the
+ * thread used up its whole quantum, so it moves down a level.
+ */
+void preempt(){
+    Thread *thread = buf[uthread_get_tid()];
+    if (schedulingPolicy == UTHREAD_POLICY_MLFQ &&
+        thread->getLevel() < UTHREAD_NUM_PRIORITIES - 1) {
+        thread->setLevel(thread->getLevel() + 1);
+    }
+    pollEvents();
+    scheduler(READY);
+}
+
+
 /**
  * Determine who's running next: moves current thread to READY,
  * pops from ready into RUNNING. Calls context switch.
  * @param state - state to move the current thread to
+ * @param next - a READY thread to run instead of the front of readyBuf.
  */
-void scheduler(int state){
+void scheduler(int state, Thread *next){
     Thread *runningThread;
     int oldID;
 
     assert (state == READY || state == RUNNING || state == BLOCKED);
 
-    if (readyBuf.size() == 0)
+    pollEventsIfDue();
+    // nothing else can run - maybe a thread that waits for I/O can:
+    if (!next && readyBuf.empty()) {
+        pollEvents();
+    }
+    // the running thread can not go on either - wait for an event:
+    if (!next && readyBuf.empty() &&
+        (currentThreadId == -1 || buf.getStatus(currentThreadId) != RUNNING)) {
+        idle();
+    }
+    if (!next && readyBuf.empty())
     {
         resetTimer();
         // main thread is running - do nothing
@@ -137,10 +289,19 @@ void scheduler(int state){
     } else {
         // move old running thread to readybuf, READY state:
         if (currentThreadId != -1){
-            if (buf.at(uthread_get_tid())->getStatus() == RUNNING){
-                readyBuf.push_back(buf[uthread_get_tid()]);
+            // under MLFQ, a thread that blocks before its quantum is over
+            // moves up a level:
+            Thread *current = buf[uthread_get_tid()];
+            if (state == BLOCKED && schedulingPolicy == UTHREAD_POLICY_MLFQ &&
+                current->getLevel() > buf.getPriority(uthread_get_tid())) {
+                current->setLevel(current->getLevel() - 1);
+            }
+            if (buf.getStatus(uthread_get_tid()) == RUNNING){
+                buf.setStatus(uthread_get_tid(), state);
+                if (state == READY) {
+                    readyBuf.pushBack(current);
+                }
             }
-            buf[uthread_get_tid()]->setStatus(state);
             oldID = uthread_get_tid();
         }
         else {
@@ -148,55 +309,255 @@ void scheduler(int state){
         }
 
         // pop new running thread from ready to running
-        runningThread = readyBuf.front();
-        readyBuf.pop_front(); // pop just deletes the element
-        runningThread->setStatus(RUNNING);
+        if (next) {
+            readyBuf.remove(next);
+            runningThread = next;
+        } else {
+            runningThread = readyBuf.popFront();
+        }
+        buf.setStatus(runningThread->getId(), RUNNING);
         currentThreadId = runningThread->getId();
+        runningSpecific = runningThread->getSpecific();
+        runningGenerations = runningThread->getSpecificGenerations();
 
         if (oldID != -1) {
             contextSwitch(oldID);
         }
         else {
             resetTimer();
-            siglongjmp(*(buf[uthread_get_tid()]->getEnvironment()), AFTER_JUMP);
+            swapContext(&deadContext, buf.getContext(uthread_get_tid()));
         }
     }
 }
 
+/**
+ * Saves the environment of thread tid and loads the one of the current thread.
+ * Returns once thread tid is scheduled again.
+ * @param tid - the thread that is switched out.
+ */
 void contextSwitch(int tid){
+    resetTimer();
+    swapContext(buf.getContext(tid),
+                buf.getContext(uthread_get_tid()));
+    reapZombie();
+}
 
-    // save environment:
-    int ret_val = sigsetjmp(*(buf[tid]->getEnvironment()),1);
-    if (ret_val == AFTER_JUMP) {
-        return;
+/**
+ * The first function every spawned thread runs. A thread is always switched
+ * to from inside a critical section, so it has to be ended before the entry
+ * point is called. A thread whose entry point returns destroys its values
+ * and its entry point, which may call the library, and terminates itself.
+ */
+void threadLauncher()
+{
+    reapZombie();
+    unMask();
+    Thread *thread = buf[uthread_get_tid()];
+    thread->runEntryPoint();
+    runKeyDestructors(thread);
+    thread->clearEntryPoint();
+    mask();
+    exitThread();
+}
+
+/**
+ * Calls the destructors of the thread-local storage keys with the thread's
+ * values, until no value is set again or UTHREAD_DESTRUCTOR_ITERATIONS rounds
+ * were made. Called outside of a critical section, since the destructors may
+ * call the library.
+ * @param thread
+ */
+void runKeyDestructors(Thread *thread)
+{
+    void **specific = thread->getSpecific();
+    unsigned int *generations = thread->getSpecificGenerations();
+    for (int round = 0; round < UTHREAD_DESTRUCTOR_ITERATIONS; round++) {
+        bool called = false;
+        for (int key = 0; key < UTHREAD_KEYS_MAX; key++) {
+            void *value = specific[key];
+            if (value && keyDestructors[key] &&
+                generations[key] == keyGenerations[key]) {
+                specific[key] = nullptr;
+                keyDestructors[key](value);
+                called = true;
+            }
+        }
+        if (!called) {
+            return;
+        }
+    }
+}
+
+/**
+ * Terminates the running thread, which is not the main thread. A running
+ * thread does not sleep or wait, and its values and entry point were
+ * destroyed before the critical section, so besides informing the threads
+ * synced to it there is nothing to undo. It is still running on its stack, so
+ * the stack is cached by the next thread to run, right after the switch. That
+ * thread starts a quantum of its own, as after any other switch. Called in a
+ * critical section; does not return.
+ */
+void exitThread()
+{
+    int tid = uthread_get_tid();
+    Thread *thread = buf[tid];
+    informDependents(tid);
+    zombie = thread;
+    buf.set(tid, nullptr);
+    ids.release(tid);
+    numThreads--;
+    currentThreadId = -1;
+    scheduler(BLOCKED);
+}
+
+void constructEntryCall(void *storage, void *callable)
+{
+    *(EntryCall *)storage = *(EntryCall *)callable;
+}
+
+void runEntryCall(void *storage)
+{
+    EntryCall *call = (EntryCall *)storage;
+    if (call->f) {
+        call->f();
+    } else {
+        call->fArg(call->arg);
+    }
+}
+
+void destroyEntryCall(void *)
+{
+}
+
+// the entry points of uthread_spawn and uthread_spawn_arg:
+static const uthread_closure_ops_t entryCallOps = {constructEntryCall,
+                                                   runEntryCall,
+                                                   destroyEntryCall};
+
+/**
+ * Creates a new thread, and adds it to the end of the READY threads list.
+ * @param ops - how the thread's entry point is moved in, run and destroyed.
+ * @param callable - the thread's entry point.
+ * @param attr - the thread's attributes, or nullptr for the defaults.
+ * @return the ID of the thread, or -1 on failure.
+ */
+int spawnThread(const uthread_closure_ops_t *ops, void *callable,
+                const uthread_attr_t *attr)
+{
+    int stackSize = (attr && attr->stack_size) ? attr->stack_size : STACK_SIZE;
+    if (stackSize < 0) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid stack size.\n";
+        return -1;
+    }
+    mask();
+    //assign id:
+    int tid = ids.allocate();
+    Thread *t = nullptr;
+    if (tid != -1)
+    {
+        // reuse a terminated thread of the same size class if there is one:
+        size_t size = ThreadCache::roundStackSize(stackSize + signalStackReserve);
+        t = threadCache.get(size);
+        if (t) {
+            t->reset(tid, threadLauncher);
+        } else {
+            Stack stack;
+            if (stack.allocate(size)) {
+                // out of memory or mappings - a failed spawn, not a fatal
+                // error, so the ID is free again:
+                ids.release(tid);
+                unMask();
+                std::cerr << ERR_FUNC_FAIL << "Stack allocation has failed.\n";
+                return -1;
+            }
+            t = new Thread(tid, threadLauncher, stack);
+        }
+    }
+    unMask();
+    if (t) {
+        // the move constructor of the entry point may call the library, so
+        // it is moved in outside of the critical section - no other thread
+        // can reach t yet:
+        t->setEntryPoint(ops, callable);
+        // insert to buffers:
+        mask();
+        buf.set(tid, t);
+        readyBuf.pushBack(t);
+        numThreads++;
+        unMask();
+    }
+
+    // error handling:
+    if (tid == -1){
+        std::cout<< ERR_FUNC_FAIL << "Number of threads exceeds limit.\n";
+    }
+    return tid;
+}
+
+/**
+ * Caches the thread that terminated itself, if there is one. Called right
+ * after a switch, when the terminated thread's stack is no longer in use.
+ */
+void reapZombie()
+{
+    if (zombie) {
+        threadCache.put(zombie);
+        zombie = nullptr;
     }
-    resetTimer();
-    // load environment:
-    siglongjmp(*(buf[uthread_get_tid()]->getEnvironment()),AFTER_JUMP);
 }
 
 /**
- * Sets a virtual timer with the time interval quantum_usecs.
+ * The timer signal is delivered on the stack of the running thread, and the
+ * handler runs the scheduler on it. This returns the space that takes, on top
+ * of what the thread itself uses. The signal frame grows with the CPU's
+ * extended register state, so the kernel is asked for its size.
+ */
+size_t getSignalStackReserve()
+{
+    size_t frameSize = MINSIGSTKSZ;
+#ifdef AT_MINSIGSTKSZ
+    if (getauxval(AT_MINSIGSTKSZ) > frameSize) {
+        frameSize = getauxval(AT_MINSIGSTKSZ);
+    }
+#endif
+    return frameSize + HANDLER_STACK_RESERVE;
+}
+
+/**
+ * Sets a timer with the time interval quantum_usecs. The timer measures the
+ * CPU time of the calling kernel thread, and signals only that thread.
  */
 int setTimer(int quantum_usecs) {
     //set timer handler:
     sa.sa_handler = &timeHandler;
+    // the handler may switch to a thread that never returns from it, so the
+    // kernel must not mask the signal while it runs. re-entry is prevented by
+    // the critical section instead.
+    sa.sa_flags = SA_NODEFER;
     if (sigaction(SIGVTALRM, &sa, nullptr) < 0) {
         std::cerr << ERR_SYS_CALL << "sigaction has failed.\n";
         exitLib(-1);
 //        return -1;
     }
+    struct sigevent event = {};
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGVTALRM;
+    event.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    if (timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer)) {
+        std::cerr << ERR_SYS_CALL << "Creating the timer has failed.\n";
+        exitLib(-1);
+    }
+
     // Configure the timer to expire after quantum micro secs:
-    timer.it_value.tv_sec = quantum_usecs / 1000000;
-    timer.it_value.tv_usec = quantum_usecs % 1000000;
+    quantum.it_value.tv_sec = quantum_usecs / 1000000;
+    quantum.it_value.tv_nsec = (quantum_usecs % 1000000) * 1000;
 
     // configure the timer to expire every quantum micro secs after that:
-    timer.it_interval.tv_sec = quantum_usecs / 1000000;
-    timer.it_interval.tv_usec = quantum_usecs % 1000000;
+    quantum.it_interval = quantum.it_value;
 
-    // Start a virtual timer. It counts down whenever this process is executing.
-    if (setitimer (ITIMER_VIRTUAL, &timer, nullptr)) {
-        std::cerr << ERR_SYS_CALL << "Setting the virtual timer has failed.\n";
+    // Start the timer. It counts down whenever this thread is executing.
+    if (timer_settime(timer, 0, &quantum, nullptr)) {
+        std::cerr << ERR_SYS_CALL << "Setting the timer has failed.\n";
 //        return -1;
         exitLib(-1);
     }
@@ -204,230 +565,798 @@ int setTimer(int quantum_usecs) {
 }
 
 /**
- * Mask the timer signal.
- * @return 0 on success, -1 on failure.
+ * Enter a critical section: the timer handler will not preempt the running
+ * thread until unMask() is called.
  */
 void mask(){
-    if (sigprocmask(SIG_BLOCK, &blockSet, nullptr)){
-        std::cerr << ERR_SYS_CALL << "Masking failed.\n";
-        exitLib(-1);
-    }
+    inCriticalSection = 1;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
 }
 
 /**
- * Release blocked signals.
- * @return 0 on success, -1 on failure.
+ * Leave the critical section, and carry out a preemption that the timer
+ * handler recorded while it was held.
  */
 void unMask(){
-    if (sigprocmask(SIG_UNBLOCK, &blockSet,  nullptr)){
-        std::cerr << ERR_SYS_CALL << "Un-masking failed.\n";
-        exitLib(-1);
+    while (true) {
+        inCriticalSection = 0;
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+        if (!preemptionPending) {
+            return;
+        }
+        inCriticalSection = 1;
+        preemptionPending = 0;
+        preempt();
     }
 }
 
 /**
- * Remove thread from the specified buffer by ID.
- * @param buffer
+ * Upon termination of a thread, informs all the threads that are synced to it.
+ * A thread that is synced to several threads until all of them terminate is
+ * only woken up by the last.
  * @param tid
  */
-void removeFromBuf(std::deque<Thread*>* buffer, int tid)
+void informDependents(int terminatedId)
 {
-    for (unsigned int idx = 0; idx < buffer->size(); idx++) {
-        if (buffer->at(idx)->getId() == tid) {
-            buffer->erase(buffer->begin() + idx);
+    WaitNode *node;
+    while ((node = WaitQueue(buf[terminatedId]->getExitWaiters()).popFront())) {
+        int *remaining = (int *)node->data;
+        if (!remaining || !--*remaining) {
+            wakeNode(node);
         }
     }
 }
 
 /**
- * Upon termination of a thread, informs all the threads that are synced to it.
- * @param tid
+ * Blocks the running thread until threads terminate. The thread waits in the
+ * exit queues of all of them at once, with a node on its stack for each.
+ * Threads that do not exist have terminated already. Called in a critical
+ * section.
+ * @param tids - IDs that are not of the running thread.
+ * @param numTids
+ * @param all - whether to wait until all of them terminate, or only until the
+ * first.
+ * @return the index of the first thread that terminated, or -1 when waiting
+ * for all of them.
  */
-void informDependents(int terminatedId)
+int waitForExit(const int *tids, int numTids, bool all)
 {
-    Thread* dependent;
-    for (int i = 0; i < buf[terminatedId]->getDependentsNum(); i++) {
-        dependent = buf[terminatedId]->popDependent();
-        if (!(dependent->getBlockedNoSync())){
-            dependent->setStatus(READY);
-            readyBuf.push_back(dependent);
-            dependent->setSynced(false);
+    Thread *current = buf[uthread_get_tid()];
+    WaitNode *nodes = (WaitNode *)alloca(numTids * sizeof(WaitNode));
+    // the number of registrations that are left, when waiting for all:
+    int remaining = 0;
+    WaitNode *first = nullptr, **link = &first;
+    for (int i = 0; i < numTids; i++) {
+        if (idValidator(tids[i])) {
+            if (!all) {
+                for (WaitNode *node = first; node; node = node->sibling) {
+                    cancelNode(node);
+                }
+                return i;
+            }
+            continue;
         }
+        WaitNode *node = new (&nodes[i]) WaitNode(current,
+                                                  all ? &remaining : nullptr);
+        WaitQueue(buf[tids[i]]->getExitWaiters()).pushBack(node);
+        remaining++;
+        *link = node;
+        link = &node->sibling;
+    }
+    if (!first) {
+        return -1;
+    }
+    current->setWaitNode(first);
+    buf.setStatus(current->getId(), BLOCKED);
+    scheduler(BLOCKED);
+    if (all) {
+        return -1;
     }
+    int woken = 0;
+    while (!nodes[woken].woken) {
+        woken++;
+    }
+    return woken;
 }
 
-
-// ---------------------------- library methods --------------------------------
-
-/*
- * Description: This function initializes the thread library.
- * You may assume that this function is called before any other thread library
- * function, and that it is called exactly once. The input to the function is
- * the length of a quantum in micro-seconds. It is an error to call this
- * function with non-positive quantum_usecs.
- * Return value: On success, return 0. On failure, return -1.
-*/
-int uthread_init(int quantum_usecs)
+/**
+ * Checks the IDs of threads to sync to. Threads that do not exist are fine -
+ * they have terminated already.
+ * @param tids
+ * @param numTids
+ * @return 0 if the IDs are valid, -1 otherwise.
+ */
+int validateSyncTargets(const int *tids, int numTids)
 {
-    if (quantum_usecs <= 0) {
-        std::cerr << ERR_FUNC_FAIL << "invalid quantum len was supplied.\n";
+    if (!tids || numTids <= 0) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid IDs to sync.\n";
         return -1;
     }
-    buf[0] = new Thread(0, nullptr, STACK_SIZE);
-    buf[0]->setStatus(RUNNING);
-    numThreads = 1;
-    currentThreadId = 0;
-    totalQuantumNum = 1; // "Right after the call to uthread_init, the value should be 1."
-
-    //init masking-signals buffers:
-    if (sigemptyset(&blockSet)) {
-        std::cerr << ERR_SYS_CALL << "Signals buffer action has failed.\n";
-        exitLib(-1);
+    for (int i = 0; i < numTids; i++) {
+        if (tids[i] <= 0 || tids[i] >= buf.capacity()) {
+            std::cerr << ERR_FUNC_FAIL << "Invalid ID to sync: ID out of "
+                    "range.\n";
+            return -1;
+        }
+        if (tids[i] == uthread_get_tid()) {
+            std::cerr << ERR_FUNC_FAIL << "Invalid ID to sync: Cannot sync "
+                    "itself.\n";
+            return -1;
+        }
     }
-    if (sigaddset(&blockSet, SIGVTALRM)){
-        std::cerr << ERR_SYS_CALL << "Signals buffer action has failed.\n";
-        exitLib(-1);
+    return 0;
+}
+
+/**
+ * Makes a thread whose wait is over READY, unless it was also blocked by
+ * uthread_block().
+ * @param thread
+ */
+void wakeUp(Thread *thread)
+{
+    if (!thread->getBlockedNoSync()) {
+        buf.setStatus(thread->getId(), READY);
+        readyBuf.pushBack(thread);
     }
+}
 
-    // set timer:
-    if (setTimer(quantum_usecs) < 0) {
-        std::cerr << ERR_SYS_CALL << "Timer initialization failed" << std::endl;
-//        return -1;
-        exitLib(-1);
+/**
+ * Blocks the running thread until fd is ready for the direction. Called in a
+ * critical section, right after the operation failed with EAGAIN - an edge
+ * that is reported before the thread is parked would be lost.
+ * @param fd
+ * @param direction - REACTOR_READ / REACTOR_WRITE.
+ * @return 0 when the operation should be retried, -1 on failure (errno is
+ * set).
+ */
+int waitForFd(int fd, int direction)
+{
+    Thread *current = buf[uthread_get_tid()];
+    WaitNode node(current, nullptr);
+    if (reactor.wait(&node, fd, direction)) {
+        return -1;
     }
-    buf[currentThreadId]->increaseNumQuantums();
+    current->setWaitNode(&node);
+    buf.setStatus(current->getId(), BLOCKED);
+    scheduler(BLOCKED);
     return 0;
 }
 
-/*
- * Description: This function creates a new thread, whose entry point is the
- * function f with the signature void f(void). The thread is added to the end
- * of the READY threads list. The uthread_spawn function should fail if it
- * would cause the number of concurrent threads to exceed the limit
- * (MAX_THREAD_NUM). Each thread should be allocated with a stack of size
- * STACK_SIZE bytes.
- * Return value: On success, return the ID of the created thread.
- * On failure, return -1.
-*/
-int uthread_spawn(void (*f)(void))
+/**
+ * Makes a thread whose I/O request completed READY, unless it was also
+ * blocked by uthread_block(). The thread may have been terminated while the
+ * request was in flight - then it is only deleted now, or by the thread that
+ * terminated it if that one still destroys its values.
+ * @param thread
+ * @param result - the result of the request (-errno on failure).
+ */
+void completeIo(Thread *thread, int result)
 {
-    int tid = -1;
-    if (numThreads < MAX_THREAD_NUM)
-    {
-        mask();
-
-        //assign id:
-        for (int i=1; i<MAX_THREAD_NUM; i++)
-        {
-            if (buf[i] == nullptr)
-            {
-                tid = i;
-                break;
-            }
+    if (buf[thread->getId()] != thread) {
+        thread->setIoPending(false);
+        if (!thread->isTerminating()) {
+            threadCache.put(thread);
         }
-
-        // initialize the new thread and insert to buffers:
-        auto t = new Thread(tid, f, STACK_SIZE);
-        readyBuf.push_back(t);
-        buf[tid] = t;
-        numThreads++;
-        unMask();
+        return;
     }
+    thread->setIoPending(false);
+    thread->setIoResult(result);
+    wakeUp(thread);
+}
 
-    // error handling:
-    if (tid == -1){
-        std::cout<< ERR_FUNC_FAIL << "Number of threads exceeds limit.\n";
+/**
+ * Collects the events that are due, without waiting: wakes up the threads
+ * whose file descriptors are ready, submits the I/O requests queued since the
+ * last call in a single batch, wakes up the threads whose requests completed,
+ * and the threads whose timers expired.
+ */
+void pollEvents()
+{
+    lastPollUsec = getMonotonicUsec();
+    if (reactor.size()) {
+        reactor.poll(0, wakeNode);
+    }
+    if (ioRing.size()) {
+        ioRing.submit();
+        ioRing.reap(completeIo);
+    }
+    if (timers.size()) {
+        timers.advance(lastPollUsec / TIMER_RESOLUTION_USEC, expireTimer);
     }
-    return tid;
-
 }
 
-
-
-/*
- * Description: This function terminates the thread with ID tid and deletes
- * it from all relevant control structures. All the resources allocated by
- * the library for this thread should be released. If no thread with ID tid
- * exists it is considered an error. Terminating the main thread
- * (tid == 0) will result in the termination of the entire process using
- * exit(0) [after releasing the assigned library memory].
- * Return value: The function returns 0 if the thread was successfully
- * terminated and -1 otherwise. If a thread terminates itself or the main
- * thread is terminated, the function does not return.
-*/
-int uthread_terminate(int tid)
+/**
+ * Polls for events if a quantum passed since they were last polled. They are
+ * polled when a quantum expires, but a thread that switches voluntarily
+ * re-arms the quantum timer, so threads that keep yielding to each other
+ * would keep it from ever expiring.
+ */
+void pollEventsIfDue()
 {
-    // check validity of input:
-    if (idValidator(tid)) {
-        std::cerr << ERR_FUNC_FAIL << "Invalid ID to terminate: ID out of range"
-                ".\n";
-        return -1;
+    if (getMonotonicUsec() - lastPollUsec >= pollIntervalUsec) {
+        pollEvents();
     }
-    mask();
-    // terminated thread != main thread:
-    if (tid) {
-        bool callScheduler = false;
-        // inform all depending threads:
-        informDependents(tid);
-        // pop out of ready list:
-        if (buf[tid]->getStatus() == READY) {
-            removeFromBuf(&readyBuf, tid);
+}
+
+/**
+ * Called when no thread can run: sleeps until an event makes one READY - a
+ * file descriptor becomes ready, an I/O request completes or a timer expires.
+ * The process does not use the CPU meanwhile. If there is no event to wait
+ * for, no thread will ever run again, and the process exits.
+ */
+void idle()
+{
+    while (true) {
+        pollEvents();
+        if (!readyBuf.empty()) {
+            return;
         }
-        // if the thread terminates itself, a scheduling decision has to be made
-        else if (buf[tid]->getStatus() == RUNNING) {
-            callScheduler = true;
+        if (!reactor.size() && !ioRing.size() && !timers.size()) {
+            std::cerr << ERR_FUNC_FAIL << "All threads are blocked, and no "
+                    "event can resume them.\n";
+            exitLib(-1);
         }
-        // delete thread:
-        delete buf[tid];
-        buf[tid] = nullptr;
-        numThreads--;
-        if (callScheduler){
-            isReady = false;
-            currentThreadId = -1;
-            timeHandler(BLOCKED);
+        // completions of I/O requests wake the process up as well:
+        if (ioRing.size() && reactor.watch(ioRing.fd())) {
+            std::cerr << ERR_SYS_CALL << "Watching the io_uring instance has "
+                    "failed.\n";
+            exitLib(-1);
         }
-        unMask();
-        return 0;
-    }
-    // terminate the main thread:
-    else {
-        exitLib(0);
+        // sleep until the next timer is due:
+        long long timeoutUsec = -1;
+        uint64_t ticks = timers.timeout();
+        if (ticks != UINT64_MAX) {
+            uint64_t now = getMonotonicUsec();
+            uint64_t due = (now / TIMER_RESOLUTION_USEC + ticks) *
+                           TIMER_RESOLUTION_USEC;
+            timeoutUsec = due > now ? (long long)(due - now) : 0;
+        }
+        reactor.poll(timeoutUsec, wakeNode);
     }
-    return -1; // we are not supposed to get here.
 }
 
+/**
+ * Blocks the running thread in a wait queue, until wakeNode() is called for
+ * it. Called in a critical section.
+ * @param queue
+ * @param data - stored in the thread's node.
+ */
+void waitInQueue(uthread_wait_queue_t *queue, void *data)
+{
+    Thread *current = buf[uthread_get_tid()];
+    WaitNode node(current, data);
+    WaitQueue(queue).pushBack(&node);
+    current->setWaitNode(&node);
+    buf.setStatus(current->getId(), BLOCKED);
+    scheduler(BLOCKED);
+}
 
-/*
- * Description: This function blocks the thread with ID tid. The thread may
- * be resumed later using uthread_resume. If no thread with ID tid exists it
- * is considered as an error. In addition, it is an error to try blocking the
- * main thread (tid == 0). If a thread blocks itself, a scheduling decision
- * should be made. Blocking a thread in BLOCKED state has no
- * effect and is not considered an error.
- * Return value: On success, return 0. On failure, return -1.
-*/
-int uthread_block(int tid)
+/**
+ * Makes the thread of a node that was removed from its wait queue READY,
+ * unless it was also blocked by uthread_block(). The other nodes of a thread
+ * that waits for several things are removed from their queues right away, so
+ * nothing else is handed to it.
+ * @param node
+ */
+void wakeNode(WaitNode *node)
 {
-    // check id validity and mask:
-    if (tid == 0 || idValidator(tid)==-1){
-        std::cerr << ERR_FUNC_FAIL << "Invalid ID to block: ID out of range"
-                ".\n";
-        return -1;
-    }
-    mask();
-    // remove from ready:
-    if (buf[tid]->getStatus() == READY) {
-        removeFromBuf(&readyBuf, tid);
+    Thread *thread = node->thread;
+    for (WaitNode *other = thread->getWaitNode(); other;
+         other = other->sibling) {
+        if (other != node) {
+            cancelNode(other);
+        }
     }
-    // set state:
-    buf[tid]->setStatus(BLOCKED);
+    node->woken = true;
+    thread->setWaitNode(nullptr);
+    wakeUp(thread);
+}
+
+/**
+ * Removes a node from its wait queue, if it is in one.
+ * @param node
+ */
+void cancelNode(WaitNode *node)
+{
+    if (node->fd != -1) {
+        reactor.cancel(node);
+    } else if (node->queue) {
+        WaitQueue(node->queue).remove(node);
+    }
+}
+
+/**
+ * Unlocks a mutex that has waiters: it stays locked, and is handed to the
+ * first of them, so no thread can take it in between. Called in a critical
+ * section.
+ * @param mutex
+ */
+void handOffMutex(uthread_mutex_t *mutex)
+{
+    WaitQueue waiters(&mutex->waiters);
+    WaitNode *next = waiters.popFront();
+    // the waiters may have been terminated:
+    if (!next) {
+        mutex->owner = -1;
+        mutex->state = MUTEX_UNLOCKED;
+        return;
+    }
+    mutex->owner = next->thread->getId();
+    mutex->state = waiters.empty() ? MUTEX_LOCKED : MUTEX_CONTENDED;
+    wakeNode(next);
+}
+
+/**
+ * Moves a signaled condition variable waiter to its mutex: it gets the mutex
+ * right away if it is unlocked, and waits for it otherwise. Called in a
+ * critical section.
+ * @param node - the waiter's node, removed from the condition variable.
+ */
+void requeueOnMutex(WaitNode *node)
+{
+    uthread_mutex_t *mutex = (uthread_mutex_t *)node->data;
+    if (mutex->state == MUTEX_UNLOCKED) {
+        mutex->state = MUTEX_LOCKED;
+        mutex->owner = node->thread->getId();
+        wakeNode(node);
+    } else {
+        mutex->state = MUTEX_CONTENDED;
+        WaitQueue(&mutex->waiters).pushBack(node);
+    }
+}
+
+/**
+ * Sends elements to a channel. A thread that waits for room is handed back
+ * the number of its elements that receivers took.
+ * @param chan
+ * @param elems
+ * @param count
+ * @param block - whether to wait until all the elements are sent.
+ * @return the number of elements that were sent, or -1 on failure (errno is
+ * set).
+ */
+ssize_t sendToChannel(uthread_chan_t *chan, const void *elems, size_t count,
+                      bool block)
+{
+    if (!chan || (!elems && count)) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid channel.\n";
+        errno = EINVAL;
+        return -1;
+    }
+    Channel *channel = (Channel *)chan;
+    const char *data = (const char *)elems;
+    size_t sent = 0;
+    mask();
+    while (!channel->isClosed()) {
+        sent += channel->send(data + sent * channel->getElemSize(),
+                              count - sent, wakeNode);
+        if (sent == count || !block) {
+            break;
+        }
+        ChannelRequest request = {(char *)data + sent * channel->getElemSize(),
+                                  count - sent, 0};
+        waitInQueue(channel->getSenders(), &request);
+        sent += request.done;
+    }
+    if (!sent && count) {
+        errno = channel->isClosed() ? EPIPE : EAGAIN;
+        return leaveIoCall(-1);
+    }
+    return leaveIoCall((ssize_t)sent);
+}
+
+/**
+ * Receives elements from a channel. A thread that waits for elements is
+ * handed them by the sender that wakes it up.
+ * @param chan
+ * @param elems
+ * @param count
+ * @param block - whether to wait until there is an element.
+ * @return the number of elements that were received, or -1 on failure (errno
+ * is set).
+ */
+ssize_t receiveFromChannel(uthread_chan_t *chan, void *elems, size_t count,
+                           bool block)
+{
+    if (!chan || (!elems && count)) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid channel.\n";
+        errno = EINVAL;
+        return -1;
+    }
+    Channel *channel = (Channel *)chan;
+    size_t received = 0;
+    mask();
+    while (count) {
+        received = channel->receive((char *)elems, count, wakeNode);
+        if (received || channel->isClosed() || !block) {
+            break;
+        }
+        ChannelRequest request = {(char *)elems, count, 0};
+        waitInQueue(channel->getReceivers(), &request);
+        // woken up with elements, or by uthread_chan_close():
+        received = request.done;
+        if (received) {
+            break;
+        }
+    }
+    if (!received && count) {
+        errno = channel->isClosed() ? EPIPE : EAGAIN;
+        return leaveIoCall(-1);
+    }
+    return leaveIoCall((ssize_t)received);
+}
+
+/**
+ * Carries out the first ready case of uthread_select. Called in a critical
+ * section.
+ * @param cases
+ * @param numCases
+ * @return the index of the case, or -1 if none is ready.
+ */
+int selectReady(uthread_select_case_t *cases, int numCases)
+{
+    // all the file descriptors are checked with a single system call - poll()
+    // skips the negative ones:
+    struct pollfd *fds = (struct pollfd *)alloca(numCases * sizeof(*fds));
+    bool anyFd = false;
+    for (int i = 0; i < numCases; i++) {
+        bool isFd = cases[i].kind == UTHREAD_SELECT_READ ||
+                    cases[i].kind == UTHREAD_SELECT_WRITE;
+        fds[i].fd = isFd ? cases[i].fd : -1;
+        fds[i].events = cases[i].kind == UTHREAD_SELECT_READ ? POLLIN : POLLOUT;
+        fds[i].revents = 0;
+        anyFd |= isFd;
+    }
+    while (anyFd && poll(fds, numCases, 0) == -1 && errno == EINTR) {}
+    for (int i = 0; i < numCases; i++) {
+        Channel *channel = (Channel *)cases[i].chan;
+        cases[i].error = 0;
+        switch (cases[i].kind) {
+            case UTHREAD_SELECT_RECV:
+                if (channel->receive((char *)cases[i].elem, 1, wakeNode)) {
+                    return i;
+                }
+                if (channel->isClosed()) {
+                    cases[i].error = EPIPE;
+                    return i;
+                }
+                break;
+            case UTHREAD_SELECT_SEND:
+                if (channel->isClosed()) {
+                    cases[i].error = EPIPE;
+                    return i;
+                }
+                if (channel->send((const char *)cases[i].elem, 1, wakeNode)) {
+                    return i;
+                }
+                break;
+            case UTHREAD_SELECT_READ:
+            case UTHREAD_SELECT_WRITE:
+                if (fds[i].revents & POLLNVAL) {
+                    cases[i].error = EBADF;
+                    return i;
+                }
+                if (fds[i].revents) {
+                    return i;
+                }
+                break;
+            default:
+                if (idValidator(cases[i].tid)) {
+                    return i;
+                }
+        }
+    }
+    return -1;
+}
+
+/**
+ * The entry point of the workers of the pool: runs the queued tasks one after
+ * the other, and waits for more when the queue is empty, until the pool is
+ * destroyed.
+ */
+void poolWorker()
+{
+    while (true) {
+        mask();
+        Future *task;
+        while (!(task = taskPool.pop())) {
+            if (taskPool.isStopping()) {
+                unMask();
+                uthread_terminate(uthread_get_tid());
+            }
+            waitInQueue(taskPool.getIdleWorkers(), nullptr);
+        }
+        unMask();
+        void *result = task->fn(task->arg);
+        mask();
+        task->result = result;
+        task->done = true;
+        WaitNode *getter = WaitQueue(&task->waiters).popFront();
+        if (getter) {
+            wakeNode(getter);
+        }
+        unMask();
+    }
+}
+
+/**
+ * @return the time of CLOCK_MONOTONIC in micro-seconds.
+ */
+uint64_t getMonotonicUsec()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * Makes a thread whose timer expired READY, unless it was also blocked by
+ * uthread_block().
+ * @param node - the thread's timer.
+ */
+void expireTimer(TimerNode *node)
+{
+    wakeUp(node->thread);
+}
+
+/**
+ * Queues an I/O request of the running thread, and blocks it until the
+ * request completes. The request is submitted with the others that are
+ * queued until the next tick, or until no thread can run. Called in a
+ * critical section.
+ * @param opcode - IORING_OP_READ / IORING_OP_WRITE.
+ * @param fd
+ * @param data
+ * @param count
+ * @param offset
+ * @return the result of the request, or -1 on failure (errno is set).
+ */
+ssize_t ringIo(int opcode, int fd, void *data, size_t count, off_t offset)
+{
+    Thread *current = buf[uthread_get_tid()];
+    ioRing.queue(opcode, fd, data, count, offset, current, completeIo);
+    current->setIoPending(true);
+    buf.setStatus(current->getId(), BLOCKED);
+    scheduler(BLOCKED);
+    if (current->getIoResult() < 0) {
+        errno = -current->getIoResult();
+        return -1;
+    }
+    return current->getIoResult();
+}
+
+/**
+ * Leaves the critical section of an I/O call. Other threads may run before it
+ * is left, so the errno of the call is kept.
+ * @param ret - the return value of the call.
+ * @return ret.
+ */
+ssize_t leaveIoCall(ssize_t ret)
+{
+    int savedErrno = errno;
+    unMask();
+    errno = savedErrno;
+    return ret;
+}
+
+
+// ---------------------------- library methods --------------------------------
+
+/*
+ * Description: This function initializes the thread library.
+ * You may assume that this function is called before any other thread library
+ * function, and that it is called exactly once. The input to the function is
+ * the length of a quantum in micro-seconds. It is an error to call this
+ * function with non-positive quantum_usecs.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_init(int quantum_usecs)
+{
+    return uthread_init_ex(quantum_usecs, MAX_THREAD_NUM);
+}
+
+/*
+ * Description: Like uthread_init, but the maximal number of concurrent
+ * threads (including the main thread) is max_threads instead of
+ * MAX_THREAD_NUM. It is an error to call this function with non-positive
+ * max_threads, or with max_threads above MAX_THREAD_LIMIT.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_init_ex(int quantum_usecs, int max_threads)
+{
+    if (quantum_usecs <= 0) {
+        std::cerr << ERR_FUNC_FAIL << "invalid quantum len was supplied.\n";
+        return -1;
+    }
+    if (max_threads <= 0 || max_threads > MAX_THREAD_LIMIT) {
+        std::cerr << ERR_FUNC_FAIL << "invalid maximal number of threads was supplied.\n";
+        return -1;
+    }
+    buf = ThreadTable(max_threads);
+    ids = IdAllocator(max_threads);
+    buf.set(ids.allocate(), new Thread(0, nullptr, Stack()));
+    buf.setStatus(0, RUNNING);
+    numThreads = 1;
+    currentThreadId = 0;
+    runningSpecific = buf[0]->getSpecific();
+    runningGenerations = buf[0]->getSpecificGenerations();
+    totalQuantumNum = 1; // "Right after the call to uthread_init, the value should be 1."
+    signalStackReserve = getSignalStackReserve();
+    pollIntervalUsec = quantum_usecs;
+    lastPollUsec = getMonotonicUsec();
+
+    // set timer:
+    if (setTimer(quantum_usecs) < 0) {
+        std::cerr << ERR_SYS_CALL << "Timer initialization failed" << std::endl;
+//        return -1;
+        exitLib(-1);
+    }
+    buf[currentThreadId]->increaseNumQuantums();
+    return 0;
+}
+
+/*
+ * Description: This function creates a new thread, whose entry point is the
+ * function f with the signature void f(void). When f returns, the thread is
+ * terminated. The thread is added to the end of the READY threads list. The uthread_spawn function should fail if it
+ * would cause the number of concurrent threads to exceed the limit
+ * (MAX_THREAD_NUM, or the one given to uthread_init_ex). Each thread should be allocated with a stack of size
+ * STACK_SIZE bytes.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+int uthread_spawn(void (*f)(void))
+{
+    return uthread_spawn_ex(f, nullptr);
+}
+
+/*
+ * Description: Like uthread_spawn, but the new thread is created with the
+ * attributes in attr. If attr is NULL, the defaults of uthread_spawn are used.
+ * The stack is rounded up to whole pages, and is followed by an inaccessible
+ * guard page, so a stack overflow terminates the process with SIGSEGV. Room
+ * for the library's signal handling is added on top of stack_size. It is
+ * an error to pass a negative stack_size.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_ex(void (*f)(void), const uthread_attr_t *attr)
+{
+    EntryCall call = {f, nullptr, nullptr};
+    return spawnThread(&entryCallOps, &call, attr);
+}
+
+/*
+ * Description: Like uthread_spawn, but the entry point is the function f with
+ * the signature void f(void *), which is called with arg.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_arg(void (*f)(void *), void *arg)
+{
+    EntryCall call = {nullptr, f, arg};
+    return spawnThread(&entryCallOps, &call, nullptr);
+}
+
+/*
+ * Description: Like uthread_spawn, but the entry point is run by ops on a
+ * copy of callable, which ops->construct moves into the thread. Used by the
+ * uthread_spawn template, which should be called instead.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_closure(const uthread_closure_ops_t *ops, void *callable)
+{
+    return spawnThread(ops, callable, nullptr);
+}
+
+
+
+/*
+ * Description: This function terminates the thread with ID tid and deletes
+ * it from all relevant control structures. All the resources allocated by
+ * the library for this thread should be released. If no thread with ID tid
+ * exists it is considered an error. Terminating the main thread
+ * (tid == 0) will result in the termination of the entire process using
+ * exit(0) [after releasing the assigned library memory].
+ * Return value: The function returns 0 if the thread was successfully
+ * terminated and -1 otherwise. If a thread terminates itself or the main
+ * thread is terminated, the function does not return.
+*/
+int uthread_terminate(int tid)
+{
+    // check validity of input:
+    if (idValidator(tid)) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid ID to terminate: ID out of range"
+                ".\n";
+        return -1;
+    }
+    // a thread that terminates itself destroys its values and its entry
+    // point while it still runs, as if it returned:
+    if (tid && tid == uthread_get_tid()) {
+        runKeyDestructors(buf[tid]);
+        buf[tid]->clearEntryPoint();
+        mask();
+        exitThread();
+    }
+    mask();
+    // terminated thread != main thread:
+    if (tid) {
+        Thread *thread = buf[tid];
+        // inform all depending threads:
+        informDependents(tid);
+        // stop sleeping:
+        if (thread->getTimer()->wheel != -1) {
+            timers.cancel(thread->getTimer());
+        }
+        // stop waiting for file descriptors, synchronization objects,
+        // channels and threads it is synced to:
+        for (WaitNode *node = thread->getWaitNode(); node;
+             node = node->sibling) {
+            cancelNode(node);
+        }
+        // pop out of ready list:
+        if (buf.getStatus(tid) == READY) {
+            readyBuf.remove(thread);
+        }
+        buf.set(tid, nullptr);
+        ids.release(tid);
+        numThreads--;
+        // the destructors of its values and of what its entry point
+        // captured may switch threads, so they are called once nothing can
+        // reach the thread anymore:
+        thread->setTerminating(true);
+        unMask();
+        runKeyDestructors(thread);
+        thread->clearEntryPoint();
+        mask();
+        thread->setTerminating(false);
+        // delete thread. a thread with an I/O request in flight is deleted
+        // once it completes, since the kernel may still write to its stack:
+        if (!thread->isIoPending()) {
+            threadCache.put(thread);
+        }
+        unMask();
+        return 0;
+    }
+    // terminate the main thread:
+    else {
+        exitLib(0);
+    }
+    return -1; // we are not supposed to get here.
+}
+
+
+/*
+ * Description: This function blocks the thread with ID tid. The thread may
+ * be resumed later using uthread_resume. If no thread with ID tid exists it
+ * is considered as an error. In addition, it is an error to try blocking the
+ * main thread (tid == 0). If a thread blocks itself, a scheduling decision
+ * should be made. Blocking a thread in BLOCKED state has no
+ * effect and is not considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_block(int tid)
+{
+    // check id validity and mask:
+    if (tid == 0 || idValidator(tid)==-1){
+        std::cerr << ERR_FUNC_FAIL << "Invalid ID to block: ID out of range"
+                ".\n";
+        return -1;
+    }
+    mask();
+    // remove from ready:
+    if (buf.getStatus(tid) == READY) {
+        readyBuf.remove(buf[tid]);
+    }
+    // set state:
+    buf.setStatus(tid, BLOCKED);
     buf[tid]->setBlockedNoSync(true);
-    // a thread blocks itself - call scheduler
+    // a thread blocks itself - call scheduler. it returns once the thread
+    // was resumed, which cleared the flag:
     if (tid == uthread_get_tid()) {
         scheduler(BLOCKED);
     }
-    buf.at(tid)->setBlockedNoSync(true); //raise blocked but not synced flag.
-
     unMask();
     return 0;
 }
@@ -441,6 +1370,18 @@ int uthread_block(int tid)
  * Return value: On success, return 0. On failure, return -1.
 */
 int uthread_resume(int tid)
+{
+    return uthread_resume_ex(tid, 0);
+}
+
+
+/*
+ * Description: Like uthread_resume. If flags contains UTHREAD_HANDOFF and the
+ * thread with ID tid is READY afterwards, the RUNNING thread also yields to
+ * it, as in uthread_yield_to.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_resume_ex(int tid, int flags)
 {
     if (idValidator(tid)==-1){
         std::cerr << ERR_FUNC_FAIL << "Invalid ID to resume: ID out of range"
@@ -449,58 +1390,1037 @@ int uthread_resume(int tid)
     }
     mask();
     // make sure thread is not active to begin with:
-    if (!(buf[tid]->getStatus() == RUNNING || buf[tid]->getStatus() == READY)){
-        if (!buf[tid]->isSynced()) //assure thread is not synced (and therefor shouldn't be resumed)
+    if (!(buf.getStatus(tid) == RUNNING || buf.getStatus(tid) == READY)){
+        //assure thread is not synced, waiting for I/O or sleeping (and
+        // therefor shouldn't be resumed)
+        if (!buf[tid]->isWaiting())
         {
-            buf[tid]->setStatus(READY);
-            readyBuf.push_back(buf[tid]);
-            buf[tid]->setBlockedNoSync(false);
+            buf.setStatus(tid, READY);
+            readyBuf.pushBack(buf[tid]);
         }
+        buf[tid]->setBlockedNoSync(false);
 
     }
+    if (flags & UTHREAD_HANDOFF && buf.getStatus(tid) == READY) {
+        keepTimer = 1;
+        scheduler(READY, buf[tid]);
+    }
     unMask();
     return 0;
 }
 
 
 /*
- * Description: This function blocks the RUNNING thread until thread with
- * ID tid will terminate. It is considered an error if no thread with ID tid
- * exists or if the main thread (tid==0) calls this function. Immediately after the
- * RUNNING thread transitions to the BLOCKED state a scheduling decision should be made.
+ * Description: This function moves the RUNNING thread to the end of the
+ * READY threads list, and a scheduling decision is made, without waiting for
+ * the quantum to end. If no other thread is READY, the RUNNING thread
+ * continues its quantum.
  * Return value: On success, return 0. On failure, return -1.
 */
-int uthread_sync(int tid)
+int uthread_yield()
 {
-    if (idValidator(tid) || tid == 0)
-    {
-        std::cerr << ERR_FUNC_FAIL << "Invalid ID to sync: ID out of range.\n";
-        return -1;
+    mask();
+    pollEventsIfDue();
+    if (!readyBuf.empty()) {
+        scheduler(READY);
     }
-    if (uthread_get_tid() == tid)
-    {
-        std::cerr << ERR_FUNC_FAIL << "Invalid ID to sync: Cannot sync itself"
-                ".\n";
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: This function switches from the RUNNING thread directly to
+ * the READY thread with ID tid, regardless of its place in the READY threads
+ * list, and the RUNNING thread moves to the end of the list. The thread with
+ * ID tid runs for the rest of the current quantum. If the thread with ID tid
+ * is not READY the call has no effect, and it is not considered an error.
+ * If no thread with ID tid exists it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_yield_to(int tid)
+{
+    if (idValidator(tid)){
+        std::cerr << ERR_FUNC_FAIL << "Invalid ID to yield to: ID out of range.\n";
         return -1;
     }
     mask();
-    // block current thread
-    buf.at(uthread_get_tid())->setStatus(BLOCKED);
-    isReady = false;
+    if (buf.getStatus(tid) == READY) {
+        // the thread runs for the rest of the quantum:
+        keepTimer = 1;
+        scheduler(READY, buf[tid]);
+    }
+    unMask();
+    return 0;
+}
 
-    // current thread should wait until tid finishes its job
-    buf.at(tid)->pushDependent(buf.at(uthread_get_tid()));
-    buf.at(uthread_get_tid())->setSynced(true); //raise synced flag
 
-    // RUNNING thread transitions to the BLOCKED state
-    //scheduling decision should be made
-    scheduler(BLOCKED);
+/*
+ * Description: This function blocks the RUNNING thread until thread with
+ * ID tid will terminate. It is considered an error if no thread with ID tid
+ * exists or if the main thread (tid==0) calls this function. Immediately after the
+ * RUNNING thread transitions to the BLOCKED state a scheduling decision should be made.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sync(int tid)
+{
+    if (idValidator(tid) || tid == 0)
+    {
+        std::cerr << ERR_FUNC_FAIL << "Invalid ID to sync: ID out of range.\n";
+        return -1;
+    }
+    if (uthread_get_tid() == tid)
+    {
+        std::cerr << ERR_FUNC_FAIL << "Invalid ID to sync: Cannot sync itself"
+                ".\n";
+        return -1;
+    }
+    mask();
+    waitForExit(&tid, 1, true);
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: These functions block the RUNNING thread until threads
+ * terminate: uthread_sync_all until all num_tids threads in tids did, and
+ * uthread_sync_any until one of them did. Threads that do not exist have
+ * terminated already. The thread waits in a list of every one of them at
+ * once, and is woken up only when it can go on. It is considered an error if
+ * an ID is out of range, is of the main thread, or is of the calling thread.
+ * Return value: On success, uthread_sync_all returns 0, and uthread_sync_any
+ * returns the ID of a thread that terminated. On failure, return -1.
+*/
+int uthread_sync_all(const int *tids, int num_tids)
+{
+    if (validateSyncTargets(tids, num_tids)) {
+        return -1;
+    }
+    mask();
+    waitForExit(tids, num_tids, true);
+    unMask();
+    return 0;
+}
+
+int uthread_sync_any(const int *tids, int num_tids)
+{
+    if (validateSyncTargets(tids, num_tids)) {
+        return -1;
+    }
+    mask();
+    int tid = tids[waitForExit(tids, num_tids, false)];
+    unMask();
+    return tid;
+}
+
+
+/*
+ * Description: This function sets the priority of the thread with ID tid.
+ * Priorities range from 0 (the highest) to UTHREAD_NUM_PRIORITIES - 1, and
+ * new threads have priority 0. A READY thread always runs before READY
+ * threads of lower priorities; threads of the same priority run round-robin.
+ * Under UTHREAD_POLICY_MLFQ the priority is the highest level the thread
+ * runs at. If no thread with ID tid exists, or priority is out of range,
+ * it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_priority(int tid, int priority)
+{
+    if (idValidator(tid)) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid ID to set priority: ID out of range.\n";
+        return -1;
+    }
+    if (priority < 0 || priority >= UTHREAD_NUM_PRIORITIES) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid priority.\n";
+        return -1;
+    }
+    mask();
+    // a READY thread is queued at its level, so it has to be queued again:
+    if (buf.getStatus(tid) == READY) {
+        readyBuf.remove(buf[tid]);
+        buf.setPriority(tid, priority);
+        buf[tid]->setLevel(priority);
+        readyBuf.pushBack(buf[tid]);
+    } else {
+        buf.setPriority(tid, priority);
+        buf[tid]->setLevel(priority);
+    }
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: This function sets the scheduling policy.
+ * UTHREAD_POLICY_RR (the default) runs threads by their priority only.
+ * UTHREAD_POLICY_MLFQ is a multi-level feedback queue: a thread that is
+ * preempted at the end of its quantum moves down a level, a thread that
+ * blocks before its quantum ends moves up a level (but never above its
+ * priority), and every MLFQ_BOOST_PERIOD quantums all threads move back to
+ * the level of their priority, so none of them starves.
+ * It is an error to pass any other policy.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_policy(int policy)
+{
+    if (policy != UTHREAD_POLICY_RR && policy != UTHREAD_POLICY_MLFQ) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid scheduling policy.\n";
+        return -1;
+    }
+    mask();
+    schedulingPolicy = policy;
+    // levels that MLFQ moved threads to do not apply to other policies:
+    readyBuf.boost();
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: This function sets the maximal number of terminated threads
+ * whose control blocks and stacks are kept, to be reused by later spawns
+ * without allocating. Cached threads above the new limit are released.
+ * The default is THREAD_CACHE_SIZE. It is an error to pass a negative limit.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_cache_limit(int max_cached)
+{
+    if (max_cached < 0) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid cache limit.\n";
+        return -1;
+    }
+    mask();
+    threadCache.setLimit(max_cached);
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: This function releases cached terminated threads until at
+ * most keep of them remain. Threads with the largest stacks are released
+ * first. It is an error to pass a negative keep.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_trim_cache(int keep)
+{
+    if (keep < 0) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid number of threads to keep.\n";
+        return -1;
+    }
+    mask();
+    threadCache.trim(keep);
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: These functions do what read(), write(), accept() and
+ * connect() do, but block only the calling thread: the file descriptor is
+ * put in non-blocking mode, and whenever the operation would block, the
+ * calling thread is moved to the BLOCKED state until the file descriptor is
+ * ready, and other threads run meanwhile. A thread blocked this way is not
+ * resumed by uthread_resume. The non-blocking mode is shared with every copy
+ * of the file descriptor, including ones in other processes.
+ * Return value: As the corresponding system call. On failure, return -1 and
+ * set errno.
+*/
+ssize_t uthread_read(int fd, void *data, size_t count)
+{
+    // the operation is tried in the critical section, so that the file
+    // descriptor cannot become ready between a failed try and the wait:
+    mask();
+    ssize_t ret = reactor.prepare(fd);
+    while (ret != -1) {
+        ret = read(fd, data, count);
+        if (ret != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            break;
+        }
+        ret = waitForFd(fd, REACTOR_READ);
+    }
+    return leaveIoCall(ret);
+}
+
+ssize_t uthread_write(int fd, const void *data, size_t count)
+{
+    mask();
+    ssize_t ret = reactor.prepare(fd);
+    while (ret != -1) {
+        ret = write(fd, data, count);
+        if (ret != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            break;
+        }
+        ret = waitForFd(fd, REACTOR_WRITE);
+    }
+    return leaveIoCall(ret);
+}
+
+int uthread_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen)
+{
+    mask();
+    int ret = reactor.prepare(sockfd);
+    while (ret != -1) {
+        ret = accept(sockfd, addr, addrlen);
+        if (ret != -1 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            break;
+        }
+        ret = waitForFd(sockfd, REACTOR_READ);
+    }
+    return (int)leaveIoCall(ret);
+}
+
+int uthread_connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen)
+{
+    mask();
+    int ret = reactor.prepare(sockfd);
+    if (ret != -1) {
+        ret = connect(sockfd, addr, addrlen);
+    }
+    // the connection is established in the background. once the socket is
+    // writable, its result is collected:
+    if (ret == -1 && errno == EINPROGRESS) {
+        ret = waitForFd(sockfd, REACTOR_WRITE);
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (ret != -1 &&
+            (ret = getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &len)) != -1
+            && error) {
+            errno = error;
+            ret = -1;
+        }
+    }
+    return (int)leaveIoCall(ret);
+}
+
+
+/*
+ * Description: These functions do what pread() and pwrite() do, but block
+ * only the calling thread: the request is queued to an io_uring instance,
+ * and the calling thread is moved to the BLOCKED state until it completes,
+ * while other threads run. Requests are submitted to the kernel in batches:
+ * all the requests queued until the next tick, or until no thread can run,
+ * are submitted together. If io_uring is not available, the system call is
+ * made directly, and blocks the process. If the calling thread is terminated
+ * while its request is in flight, the request still completes, and may still
+ * write to the buffer.
+ * Return value: As the corresponding system call. On failure, return -1 and
+ * set errno.
+*/
+ssize_t uthread_pread(int fd, void *data, size_t count, off_t offset)
+{
+    mask();
+    if (!ioRing.available()) {
+        unMask();
+        return pread(fd, data, count, offset);
+    }
+    return leaveIoCall(ringIo(IORING_OP_READ, fd, data, count, offset));
+}
+
+ssize_t uthread_pwrite(int fd, const void *data, size_t count, off_t offset)
+{
+    mask();
+    if (!ioRing.available()) {
+        unMask();
+        return pwrite(fd, data, count, offset);
+    }
+    return leaveIoCall(ringIo(IORING_OP_WRITE, fd, (void *)data, count,
+                              offset));
+}
+
+
+/*
+ * Description: This function blocks the calling thread for usec
+ * micro-seconds, while other threads run. The thread is moved to the BLOCKED
+ * state, and back to READY once the time has passed (the earliest tick after
+ * it, or the earliest time no other thread can run). A sleeping thread is not
+ * resumed by uthread_resume. It is an error to call this function with a
+ * negative usec.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_usec(int usec)
+{
+    if (usec < 0) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid time to sleep.\n";
+        return -1;
+    }
+    struct timespec deadline;
+    uint64_t deadlineUsec = getMonotonicUsec() + usec;
+    deadline.tv_sec = (time_t)(deadlineUsec / 1000000);
+    deadline.tv_nsec = (long)(deadlineUsec % 1000000) * 1000;
+    return uthread_sleep_until(&deadline);
+}
+
+/*
+ * Description: Like uthread_sleep_usec, but the calling thread sleeps until
+ * deadline, an absolute time of CLOCK_MONOTONIC. It is an error to call this
+ * function with an invalid deadline.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_until(const struct timespec *deadline)
+{
+    if (!deadline || deadline->tv_sec < 0 || deadline->tv_nsec < 0 ||
+        deadline->tv_nsec >= 1000000000) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid deadline to sleep until.\n";
+        return -1;
+    }
+    uint64_t deadlineUsec = (uint64_t)deadline->tv_sec * 1000000 +
+                            (deadline->tv_nsec + 999) / 1000;
+    mask();
+    Thread *current = buf[uthread_get_tid()];
+    uint64_t now;
+    // a timer that is further away than the wheels reach expires early:
+    while ((now = getMonotonicUsec()) < deadlineUsec) {
+        timers.advance(now / TIMER_RESOLUTION_USEC, expireTimer);
+        timers.add(current->getTimer(),
+                   (deadlineUsec + TIMER_RESOLUTION_USEC - 1) /
+                   TIMER_RESOLUTION_USEC);
+        buf.setStatus(current->getId(), BLOCKED);
+        scheduler(BLOCKED);
+    }
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: This function initializes a mutex as unlocked. It is the same
+ * as initializing it with UTHREAD_MUTEX_INITIALIZER.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_init(uthread_mutex_t *mutex)
+{
+    if (!mutex) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid mutex.\n";
+        return -1;
+    }
+    uthread_mutex_t unlocked = UTHREAD_MUTEX_INITIALIZER;
+    *mutex = unlocked;
+    return 0;
+}
+
+/*
+ * Description: This function locks a mutex. If it is held by another thread,
+ * the calling thread is moved to the BLOCKED state until the mutex is handed
+ * to it: threads get the mutex in the order they started waiting for it.
+ * Locking a mutex that no thread holds involves no system call and no
+ * critical section. It is an error to lock a mutex that the calling thread
+ * already holds.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_lock(uthread_mutex_t *mutex)
+{
+    if (!mutex) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid mutex.\n";
+        return -1;
+    }
+    // the compare-and-swap is a single instruction, so it can not be
+    // preempted half way:
+    int unlocked = MUTEX_UNLOCKED;
+    if (__atomic_compare_exchange_n(&mutex->state, &unlocked, MUTEX_LOCKED,
+                                    false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        mutex->owner = uthread_get_tid();
+        return 0;
+    }
+    if (mutex->owner == uthread_get_tid()) {
+        std::cerr << ERR_FUNC_FAIL << "The mutex is already locked by the "
+                "calling thread.\n";
+        return -1;
+    }
+    mask();
+    // it may have been unlocked before the critical section:
+    if (mutex->state == MUTEX_UNLOCKED) {
+        mutex->state = MUTEX_LOCKED;
+        mutex->owner = uthread_get_tid();
+    } else {
+        // the mutex is handed to this thread when it is woken up:
+        mutex->state = MUTEX_CONTENDED;
+        waitInQueue(&mutex->waiters, mutex);
+    }
+    unMask();
+    return 0;
+}
+
+/*
+ * Description: Like uthread_mutex_lock, but fails instead of blocking if the
+ * mutex is held by a thread.
+ * Return value: On success, return 0. If the mutex is held, or on failure,
+ * return -1.
+*/
+int uthread_mutex_trylock(uthread_mutex_t *mutex)
+{
+    if (!mutex) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid mutex.\n";
+        return -1;
+    }
+    int unlocked = MUTEX_UNLOCKED;
+    if (__atomic_compare_exchange_n(&mutex->state, &unlocked, MUTEX_LOCKED,
+                                    false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+        mutex->owner = uthread_get_tid();
+        return 0;
+    }
+    return -1;
+}
+
+/*
+ * Description: This function unlocks a mutex that the calling thread holds.
+ * If threads wait for it, it is handed to the first of them, which is moved
+ * to the READY state. It is an error to unlock a mutex that the calling
+ * thread does not hold.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_unlock(uthread_mutex_t *mutex)
+{
+    if (!mutex || mutex->owner != uthread_get_tid()) {
+        std::cerr << ERR_FUNC_FAIL << "The mutex is not locked by the calling "
+                "thread.\n";
+        return -1;
+    }
+    mutex->owner = -1;
+    int locked = MUTEX_LOCKED;
+    if (__atomic_compare_exchange_n(&mutex->state, &locked, MUTEX_UNLOCKED,
+                                    false, __ATOMIC_RELEASE,
+                                    __ATOMIC_RELAXED)) {
+        return 0;
+    }
+    mask();
+    handOffMutex(mutex);
+    unMask();
+    return 0;
+}
+
+/*
+ * Description: This function initializes a condition variable. It is the
+ * same as initializing it with UTHREAD_COND_INITIALIZER.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_init(uthread_cond_t *cond)
+{
+    if (!cond) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid condition variable.\n";
+        return -1;
+    }
+    cond->waiters.head = cond->waiters.tail = nullptr;
+    return 0;
+}
+
+/*
+ * Description: This function unlocks mutex, which the calling thread must
+ * hold, and moves the calling thread to the BLOCKED state until cond is
+ * signaled. The thread returns holding the mutex again: a signaled thread
+ * waits for the mutex like uthread_mutex_lock does, without running first.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_wait(uthread_cond_t *cond, uthread_mutex_t *mutex)
+{
+    if (!cond) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid condition variable.\n";
+        return -1;
+    }
+    if (!mutex || mutex->owner != uthread_get_tid()) {
+        std::cerr << ERR_FUNC_FAIL << "The mutex is not locked by the calling "
+                "thread.\n";
+        return -1;
+    }
+    mask();
+    handOffMutex(mutex);
+    // the mutex is handed back to this thread when it is woken up:
+    waitInQueue(&cond->waiters, mutex);
+    unMask();
+    return 0;
+}
+
+/*
+ * Description: uthread_cond_signal wakes up the thread that waits the
+ * longest for cond, and uthread_cond_broadcast wakes up all of them. Doing
+ * so when no thread waits involves no critical section.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_signal(uthread_cond_t *cond)
+{
+    if (!cond) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid condition variable.\n";
+        return -1;
+    }
+    if (!cond->waiters.head) {
+        return 0;
+    }
+    mask();
+    WaitNode *node = WaitQueue(&cond->waiters).popFront();
+    if (node) {
+        requeueOnMutex(node);
+    }
+    unMask();
+    return 0;
+}
+
+int uthread_cond_broadcast(uthread_cond_t *cond)
+{
+    if (!cond) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid condition variable.\n";
+        return -1;
+    }
+    if (!cond->waiters.head) {
+        return 0;
+    }
+    mask();
+    WaitNode *node;
+    while ((node = WaitQueue(&cond->waiters).popFront())) {
+        requeueOnMutex(node);
+    }
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: This function creates a channel that passes elements of
+ * elem_size bytes between threads, in the order they were sent. It buffers up
+ * to capacity elements; a channel with no capacity passes an element only
+ * when a sender meets a receiver.
+ * Return value: On success, return the channel. On failure, return NULL.
+*/
+uthread_chan_t *uthread_chan_create(size_t elem_size, size_t capacity)
+{
+    if (!elem_size) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid element size.\n";
+        return nullptr;
+    }
+    return (uthread_chan_t *)new Channel(elem_size, capacity);
+}
+
+/*
+ * Description: This function frees a channel. It is an error to destroy a
+ * channel that threads wait in.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_chan_destroy(uthread_chan_t *chan)
+{
+    Channel *channel = (Channel *)chan;
+    if (!channel) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid channel.\n";
+        return -1;
+    }
+    if (channel->hasWaiters()) {
+        std::cerr << ERR_FUNC_FAIL << "Threads wait in the channel.\n";
+        return -1;
+    }
+    delete channel;
+    return 0;
+}
+
+/*
+ * Description: uthread_chan_send copies an element into the channel. If it
+ * is full, the calling thread is moved to the BLOCKED state until a receiver
+ * takes the element. uthread_chan_recv copies the first element of the
+ * channel out. If it is empty, the calling thread is moved to the BLOCKED
+ * state until a sender copies an element straight to it. Waiting threads
+ * are served in FIFO order, and are not resumed by uthread_resume.
+ * Return value: On success, return 0. On failure, return -1 and set errno:
+ * EPIPE if the channel was closed (and, for uthread_chan_recv, is empty).
+*/
+int uthread_chan_send(uthread_chan_t *chan, const void *elem)
+{
+    return sendToChannel(chan, elem, 1, true) == 1 ? 0 : -1;
+}
 
+int uthread_chan_recv(uthread_chan_t *chan, void *elem)
+{
+    return receiveFromChannel(chan, elem, 1, true) == 1 ? 0 : -1;
+}
+
+/*
+ * Description: Like uthread_chan_send and uthread_chan_recv, but fail
+ * instead of blocking.
+ * Return value: On success, return 0. On failure, return -1 and set errno:
+ * EAGAIN if the channel is full (empty), EPIPE if it was closed.
+*/
+int uthread_chan_try_send(uthread_chan_t *chan, const void *elem)
+{
+    return sendToChannel(chan, elem, 1, false) == 1 ? 0 : -1;
+}
+
+int uthread_chan_try_recv(uthread_chan_t *chan, void *elem)
+{
+    return receiveFromChannel(chan, elem, 1, false) == 1 ? 0 : -1;
+}
+
+/*
+ * Description: uthread_chan_send_n sends count elements, blocking until all
+ * of them are in the channel or taken by receivers. uthread_chan_recv_n
+ * receives up to count elements, blocking only until there is at least one.
+ * Passing a batch wakes every waiting thread at most once, and the threads
+ * on the other side are handed as many elements as they asked for.
+ * Return value: On success, return the number of elements that were passed,
+ * which is less than count for uthread_chan_send_n only if the channel was
+ * closed meanwhile. On failure, return -1 and set errno, as
+ * uthread_chan_send and uthread_chan_recv.
+*/
+ssize_t uthread_chan_send_n(uthread_chan_t *chan, const void *elems,
+                            size_t count)
+{
+    return sendToChannel(chan, elems, count, true);
+}
+
+ssize_t uthread_chan_recv_n(uthread_chan_t *chan, void *elems, size_t count)
+{
+    return receiveFromChannel(chan, elems, count, true);
+}
+
+/*
+ * Description: This function closes a channel: sending fails from now on,
+ * and receiving fails once the channel is empty. Threads that wait in the
+ * channel are woken up.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_chan_close(uthread_chan_t *chan)
+{
+    Channel *channel = (Channel *)chan;
+    if (!channel) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid channel.\n";
+        return -1;
+    }
+    mask();
+    channel->close(wakeNode);
     unMask();
     return 0;
 }
 
 
+/*
+ * Description: This function waits until one of num_cases cases is ready,
+ * and carries it out: an element is received or sent, a file descriptor is
+ * readable or writable, or a thread terminated (a thread that does not exist
+ * has terminated already; the ID has to be in range, and not the one of the
+ * main thread or of the calling thread). If none is ready, the calling thread is moved to
+ * the BLOCKED state, registered in all of them at once, until the first one
+ * becomes ready; its other registrations are then removed right away. If
+ * several cases are ready, the first of them is chosen. A case fails if its
+ * channel was closed (EPIPE, receiving only once the channel is empty) or its
+ * file descriptor was closed by uthread_close (EBADF); its error is set then.
+ * Return value: On success, return the index of the chosen case. On failure,
+ * return -1.
+*/
+int uthread_select(uthread_select_case_t *cases, int num_cases)
+{
+    if (!cases || num_cases <= 0) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid select cases.\n";
+        return -1;
+    }
+    for (int i = 0; i < num_cases; i++) {
+        uthread_select_case_t *c = &cases[i];
+        bool valid;
+        switch (c->kind) {
+            case UTHREAD_SELECT_RECV:
+            case UTHREAD_SELECT_SEND:
+                valid = c->chan && c->elem;
+                break;
+            case UTHREAD_SELECT_READ:
+            case UTHREAD_SELECT_WRITE:
+                valid = c->fd >= 0;
+                break;
+            case UTHREAD_SELECT_EXIT:
+                // like the IDs to sync to:
+                valid = c->tid > 0 && c->tid < buf.capacity() &&
+                        c->tid != uthread_get_tid();
+                break;
+            default:
+                valid = false;
+        }
+        if (!valid) {
+            std::cerr << ERR_FUNC_FAIL << "Invalid select case.\n";
+            return -1;
+        }
+    }
+    // a node and a request for every case, on the stack of the thread:
+    struct SelectWait
+    {
+        WaitNode node;
+        ChannelRequest request;
+    };
+    SelectWait *waits = (SelectWait *)alloca(num_cases * sizeof(SelectWait));
+    Thread *current = buf[uthread_get_tid()];
+    mask();
+    int chosen;
+    while ((chosen = selectReady(cases, num_cases)) == -1) {
+        WaitNode *first = nullptr, **link = &first;
+        for (int i = 0; i < num_cases; i++) {
+            uthread_select_case_t *c = &cases[i];
+            Channel *channel = (Channel *)c->chan;
+            WaitNode *node = new (&waits[i].node) WaitNode(current,
+                                                           &waits[i].request);
+            waits[i].request = {(char *)c->elem, 1, 0};
+            int ret = 0;
+            switch (c->kind) {
+                case UTHREAD_SELECT_RECV:
+                    WaitQueue(channel->getReceivers()).pushBack(node);
+                    break;
+                case UTHREAD_SELECT_SEND:
+                    WaitQueue(channel->getSenders()).pushBack(node);
+                    break;
+                case UTHREAD_SELECT_READ:
+                    ret = reactor.wait(node, c->fd, REACTOR_READ);
+                    break;
+                case UTHREAD_SELECT_WRITE:
+                    ret = reactor.wait(node, c->fd, REACTOR_WRITE);
+                    break;
+                default:
+                    // nodes in exit queues carry no data (informDependents()):
+                    node->data = nullptr;
+                    WaitQueue(buf[c->tid]->getExitWaiters()).pushBack(node);
+            }
+            if (ret) {
+                // the case fails - the cases before it stop waiting:
+                c->error = errno;
+                for (WaitNode *other = first; other; other = other->sibling) {
+                    cancelNode(other);
+                }
+                unMask();
+                return i;
+            }
+            *link = node;
+            link = &node->sibling;
+        }
+        current->setWaitNode(first);
+        buf.setStatus(current->getId(), BLOCKED);
+        scheduler(BLOCKED);
+        // the case that woke the thread up:
+        for (int i = 0; i < num_cases; i++) {
+            if (!waits[i].node.woken) {
+                continue;
+            }
+            int kind = cases[i].kind;
+            if (kind == UTHREAD_SELECT_RECV || kind == UTHREAD_SELECT_SEND) {
+                // the element was passed, or the channel was closed:
+                cases[i].error = waits[i].request.done ? 0 : EPIPE;
+                chosen = i;
+            } else if (kind == UTHREAD_SELECT_EXIT) {
+                cases[i].error = 0;
+                chosen = i;
+            }
+            // a file descriptor is checked again - the edge that woke the
+            // thread up may be old:
+            break;
+        }
+        if (chosen != -1) {
+            break;
+        }
+    }
+    unMask();
+    return chosen;
+}
+
+
+/*
+ * Description: This function creates the pool of the library: num_workers
+ * threads, spawned as by uthread_spawn, that run the tasks submitted with
+ * uthread_submit in the order they were submitted. It is an error to create
+ * the pool while it exists, or if not all the workers can be spawned.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_pool_create(int num_workers)
+{
+    std::vector<int> &workers = taskPool.getWorkers();
+    if (num_workers <= 0 || !workers.empty()) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid pool size, or the pool "
+                "exists.\n";
+        return -1;
+    }
+    taskPool.setStopping(false);
+    for (int i = 0; i < num_workers; i++) {
+        int tid = uthread_spawn(poolWorker);
+        if (tid == -1) {
+            if (!workers.empty()) {
+                uthread_pool_destroy();
+            }
+            return -1;
+        }
+        workers.push_back(tid);
+    }
+    return 0;
+}
+
+/*
+ * Description: This function queues a task that calls fn(arg) on a worker of
+ * the pool. Submitting does not block, and after the first tasks allocates
+ * nothing: a future is reused once its result is taken.
+ * Return value: On success, return the future of the task's result, which
+ * must be passed to uthread_future_get exactly once. On failure, return
+ * NULL.
+*/
+uthread_future_t *uthread_submit(void *(*fn)(void *), void *arg)
+{
+    if (!fn || taskPool.getWorkers().empty() || taskPool.isStopping()) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid task, or there is no pool.\n";
+        return nullptr;
+    }
+    mask();
+    Future *future = taskPool.acquire(fn, arg);
+    taskPool.push(future);
+    WaitNode *worker = WaitQueue(taskPool.getIdleWorkers()).popFront();
+    if (worker) {
+        wakeNode(worker);
+    }
+    unMask();
+    return (uthread_future_t *)future;
+}
+
+/*
+ * Description: This function moves the calling thread to the BLOCKED state
+ * until the task of future returned, unless it already did, and releases the
+ * future. A worker must not wait for a task that is queued after its own.
+ * Return value: On success, return 0, and store what the task returned in
+ * *result if result is not NULL. On failure, return -1.
+*/
+int uthread_future_get(uthread_future_t *future, void **result)
+{
+    Future *task = (Future *)future;
+    if (!task) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid future.\n";
+        return -1;
+    }
+    mask();
+    if (!task->done) {
+        waitInQueue(&task->waiters, nullptr);
+    }
+    if (result) {
+        *result = task->result;
+    }
+    taskPool.release(task);
+    unMask();
+    return 0;
+}
+
+/*
+ * Description: This function destroys the pool: the calling thread waits
+ * until the workers ran the tasks that are queued and terminated. It is an
+ * error to destroy the pool from one of its workers, or if it does not
+ * exist.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_pool_destroy()
+{
+    std::vector<int> &workers = taskPool.getWorkers();
+    if (workers.empty() || std::find(workers.begin(), workers.end(),
+                                     uthread_get_tid()) != workers.end()) {
+        std::cerr << ERR_FUNC_FAIL << "There is no pool, or it is destroyed "
+                "by its worker.\n";
+        return -1;
+    }
+    mask();
+    taskPool.setStopping(true);
+    WaitNode *worker;
+    while ((worker = WaitQueue(taskPool.getIdleWorkers()).popFront())) {
+        wakeNode(worker);
+    }
+    waitForExit(workers.data(), (int)workers.size(), true);
+    workers.clear();
+    unMask();
+    return 0;
+}
+
+
+/*
+ * Description: This function creates a thread-local storage key, whose value
+ * is NULL in every thread until the thread sets it with
+ * uthread_setspecific. When a thread is terminated or returns from its entry
+ * point, destructor (if not NULL) is called with each non-NULL value of the
+ * key. The destructors run in the thread that calls uthread_terminate, or in
+ * the thread itself when it returns, and if they set values again they are
+ * called again, up to UTHREAD_DESTRUCTOR_ITERATIONS times. It is an error to
+ * create more than UTHREAD_KEYS_MAX keys.
+ * Return value: On success, store the key in *key and return 0. On failure,
+ * return -1.
+*/
+int uthread_key_create(uthread_key_t *key, void (*destructor)(void *))
+{
+    if (!key) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid key.\n";
+        return -1;
+    }
+    mask();
+    int newKey = 0;
+    while (newKey < UTHREAD_KEYS_MAX && keyCreated[newKey]) {
+        newKey++;
+    }
+    if (newKey == UTHREAD_KEYS_MAX) {
+        unMask();
+        std::cerr << ERR_FUNC_FAIL << "Too many keys.\n";
+        return -1;
+    }
+    keyCreated[newKey] = true;
+    keyDestructors[newKey] = destructor;
+    // the values a deleted key left behind are stale from now on:
+    keyGenerations[newKey]++;
+    unMask();
+    *key = newKey;
+    return 0;
+}
+
+/*
+ * Description: This function deletes a key. Its destructor is not called,
+ * and the key may be returned by uthread_key_create again.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_key_delete(uthread_key_t key)
+{
+    if (key < 0 || key >= UTHREAD_KEYS_MAX || !keyCreated[key]) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid key.\n";
+        return -1;
+    }
+    mask();
+    keyCreated[key] = false;
+    keyDestructors[key] = nullptr;
+    unMask();
+    return 0;
+}
+
+/*
+ * Description: These functions get and set the value of key in the RUNNING
+ * thread. A key that is out of range has the value NULL.
+ * Return value: uthread_getspecific returns the value. uthread_setspecific
+ * returns 0 on success and -1 on failure.
+*/
+void *uthread_getspecific(uthread_key_t key)
+{
+    // two loads from the running thread's values, for hot paths:
+    if ((unsigned int)key >= UTHREAD_KEYS_MAX ||
+        runningGenerations[key] != keyGenerations[key]) {
+        return nullptr;
+    }
+    return runningSpecific[key];
+}
+
+int uthread_setspecific(uthread_key_t key, const void *value)
+{
+    if (key < 0 || key >= UTHREAD_KEYS_MAX || !keyCreated[key]) {
+        std::cerr << ERR_FUNC_FAIL << "Invalid key.\n";
+        return -1;
+    }
+    runningSpecific[key] = (void *)value;
+    runningGenerations[key] = keyGenerations[key];
+    return 0;
+}
+
+
+/*
+ * Description: This function closes a file descriptor that was passed to
+ * the functions above. It must be used instead of close(), so that a new file
+ * descriptor with the same number is set up again. Threads blocked on the
+ * file descriptor are woken up, and their calls fail with EBADF.
+ * Return value: As close().
+*/
+int uthread_close(int fd)
+{
+    mask();
+    reactor.forget(fd, wakeNode);
+    return (int)leaveIoCall(close(fd));
+}
+
+
 /*
  * Description: This function returns the thread ID of the calling thread.
  * Return value: The ID of the calling thread.
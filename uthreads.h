@@ -1,5 +1,12 @@
 #ifndef _UTHREADS_H
 #define _UTHREADS_H
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 /*
  * User-Level Threads Library (uthreads)
@@ -7,7 +14,85 @@
  */
 
 #define MAX_THREAD_NUM 100 /* maximal number of threads */
+#define MAX_THREAD_LIMIT (1 << 24) /* largest max_threads of uthread_init_ex */
 #define STACK_SIZE 4096 /* stack size per thread (in bytes) */
+#define THREAD_CACHE_SIZE 64 /* default number of terminated threads kept for reuse */
+#define UTHREAD_NUM_PRIORITIES 8 /* priorities are 0 (highest) to UTHREAD_NUM_PRIORITIES - 1 */
+#define MLFQ_BOOST_PERIOD 100 /* quantums between priority boosts of UTHREAD_POLICY_MLFQ */
+#define UTHREAD_CLOSURE_SIZE 64 /* bytes of a callable that are stored in the thread itself */
+#define UTHREAD_KEYS_MAX 32 /* maximal number of thread-local storage keys */
+#define UTHREAD_DESTRUCTOR_ITERATIONS 4 /* rounds of key destructors on terminate */
+
+/* scheduling policies */
+#define UTHREAD_POLICY_RR 0 /* round-robin within each priority */
+#define UTHREAD_POLICY_MLFQ 1 /* multi-level feedback queue */
+
+/* Attributes of a spawned thread (see uthread_spawn_ex) */
+typedef struct uthread_attr
+{
+    int stack_size; /* stack size in bytes, 0 for STACK_SIZE */
+} uthread_attr_t;
+
+/* How a thread runs its entry point (see the uthread_spawn template). The
+ * callable is kept in UTHREAD_CLOSURE_SIZE bytes inside the thread. */
+typedef struct uthread_closure_ops
+{
+    void (*construct)(void *storage, void *callable); /* move callable in */
+    void (*run)(void *storage);
+    void (*destroy)(void *storage);
+} uthread_closure_ops_t;
+
+/* A thread-local storage key (see uthread_key_create) */
+typedef int uthread_key_t;
+
+/* flags of uthread_resume_ex */
+#define UTHREAD_HANDOFF 1 /* switch to the resumed thread right away */
+
+/* A FIFO queue of waiting threads, managed by the library */
+typedef struct uthread_wait_queue
+{
+    void *head, *tail;
+} uthread_wait_queue_t;
+
+/* A mutex (see uthread_mutex_lock) */
+typedef struct uthread_mutex
+{
+    int state; /* unlocked, locked, or locked with waiters */
+    int owner; /* ID of the thread that holds the mutex, -1 if none */
+    uthread_wait_queue_t waiters;
+} uthread_mutex_t;
+#define UTHREAD_MUTEX_INITIALIZER {0, -1, {0, 0}}
+
+/* A condition variable (see uthread_cond_wait) */
+typedef struct uthread_cond
+{
+    uthread_wait_queue_t waiters;
+} uthread_cond_t;
+#define UTHREAD_COND_INITIALIZER {{0, 0}}
+
+/* A bounded channel (see uthread_chan_create), managed by the library */
+typedef struct uthread_chan uthread_chan_t;
+
+/* The result of a task of the pool (see uthread_submit) */
+typedef struct uthread_future uthread_future_t;
+
+/* kinds of uthread_select cases */
+#define UTHREAD_SELECT_RECV 0 /* an element can be received from chan */
+#define UTHREAD_SELECT_SEND 1 /* an element can be sent to chan */
+#define UTHREAD_SELECT_READ 2 /* fd is readable */
+#define UTHREAD_SELECT_WRITE 3 /* fd is writable */
+#define UTHREAD_SELECT_EXIT 4 /* thread tid terminated */
+
+/* Something uthread_select waits for */
+typedef struct uthread_select_case
+{
+    int kind; /* UTHREAD_SELECT_* */
+    uthread_chan_t *chan; /* RECV / SEND */
+    void *elem; /* RECV / SEND: where the element is received to / sent from */
+    int fd; /* READ / WRITE */
+    int tid; /* EXIT */
+    int error; /* set by uthread_select: 0, or errno of a failed case */
+} uthread_select_case_t;
 
 /* External interface */
 
@@ -24,12 +109,21 @@ void printLeakageCount();
 */
 int uthread_init(int quantum_usecs);
 
+/*
+ * Description: Like uthread_init, but the maximal number of concurrent
+ * threads (including the main thread) is max_threads instead of
+ * MAX_THREAD_NUM. It is an error to call this function with non-positive
+ * max_threads, or with max_threads above MAX_THREAD_LIMIT.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_init_ex(int quantum_usecs, int max_threads);
+
 /*
  * Description: This function creates a new thread, whose entry point is the
- * function f with the signature void f(void). The thread is added to the end
- * of the READY threads list. The uthread_spawn function should fail if it
+ * function f with the signature void f(void). When f returns, the thread is
+ * terminated. The thread is added to the end of the READY threads list. The uthread_spawn function should fail if it
  * would cause the number of concurrent threads to exceed the limit
- * (MAX_THREAD_NUM). Each thread should be allocated with a stack of size
+ * (MAX_THREAD_NUM, or the one given to uthread_init_ex). Each thread should be allocated with a stack of size
  * STACK_SIZE bytes.
  * Return value: On success, return the ID of the created thread.
  * On failure, return -1.
@@ -37,6 +131,39 @@ int uthread_init(int quantum_usecs);
 int uthread_spawn(void (*f)(void));
 
 
+/*
+ * Description: Like uthread_spawn, but the new thread is created with the
+ * attributes in attr. If attr is NULL, the defaults of uthread_spawn are used.
+ * The stack is rounded up to whole pages, and is followed by an inaccessible
+ * guard page, so a stack overflow terminates the process with SIGSEGV. Room
+ * for the library's signal handling is added on top of stack_size. It is
+ * an error to pass a negative stack_size. If the stack cannot be mapped, the
+ * spawn fails and the process goes on.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_ex(void (*f)(void), const uthread_attr_t *attr);
+
+
+/*
+ * Description: Like uthread_spawn, but the entry point is the function f with
+ * the signature void f(void *), which is called with arg.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_arg(void (*f)(void *), void *arg);
+
+
+/*
+ * Description: Like uthread_spawn, but the entry point is run by ops on a
+ * copy of callable, which ops->construct moves into the thread. Used by the
+ * uthread_spawn template, which should be called instead.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+int uthread_spawn_closure(const uthread_closure_ops_t *ops, void *callable);
+
+
 /*
  * Description: This function terminates the thread with ID tid and deletes
  * it from all relevant control structures. All the resources allocated by
@@ -73,6 +200,37 @@ int uthread_block(int tid);
 int uthread_resume(int tid);
 
 
+/*
+ * Description: Like uthread_resume. If flags contains UTHREAD_HANDOFF and the
+ * thread with ID tid is READY afterwards, the RUNNING thread also yields to
+ * it, as in uthread_yield_to.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_resume_ex(int tid, int flags);
+
+
+/*
+ * Description: This function moves the RUNNING thread to the end of the
+ * READY threads list, and a scheduling decision is made, without waiting for
+ * the quantum to end. If no other thread is READY, the RUNNING thread
+ * continues its quantum.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_yield();
+
+
+/*
+ * Description: This function switches from the RUNNING thread directly to
+ * the READY thread with ID tid, regardless of its place in the READY threads
+ * list, and the RUNNING thread moves to the end of the list. The thread with
+ * ID tid runs for the rest of the current quantum. If the thread with ID tid
+ * is not READY the call has no effect, and it is not considered an error.
+ * If no thread with ID tid exists it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_yield_to(int tid);
+
+
 /*
  * Description: This function blocks the RUNNING thread until thread with
  * ID tid will terminate. It is considered an error if no thread with ID tid
@@ -83,6 +241,354 @@ int uthread_resume(int tid);
 int uthread_sync(int tid);
 
 
+/*
+ * Description: These functions block the RUNNING thread until threads
+ * terminate: uthread_sync_all until all num_tids threads in tids did, and
+ * uthread_sync_any until one of them did. Threads that do not exist have
+ * terminated already. The thread waits in a list of every one of them at
+ * once, and is woken up only when it can go on. It is considered an error if
+ * an ID is out of range, is of the main thread, or is of the calling thread.
+ * Return value: On success, uthread_sync_all returns 0, and uthread_sync_any
+ * returns the ID of a thread that terminated. On failure, return -1.
+*/
+int uthread_sync_all(const int *tids, int num_tids);
+int uthread_sync_any(const int *tids, int num_tids);
+
+
+/*
+ * Description: This function sets the priority of the thread with ID tid.
+ * Priorities range from 0 (the highest) to UTHREAD_NUM_PRIORITIES - 1, and
+ * new threads have priority 0. A READY thread always runs before READY
+ * threads of lower priorities; threads of the same priority run round-robin.
+ * Under UTHREAD_POLICY_MLFQ the priority is the highest level the thread
+ * runs at. If no thread with ID tid exists, or priority is out of range,
+ * it is considered an error.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_priority(int tid, int priority);
+
+
+/*
+ * Description: This function sets the scheduling policy.
+ * UTHREAD_POLICY_RR (the default) runs threads by their priority only.
+ * UTHREAD_POLICY_MLFQ is a multi-level feedback queue: a thread that is
+ * preempted at the end of its quantum moves down a level, a thread that
+ * blocks before its quantum ends moves up a level (but never above its
+ * priority), and every MLFQ_BOOST_PERIOD quantums all threads move back to
+ * the level of their priority, so none of them starves.
+ * It is an error to pass any other policy.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_policy(int policy);
+
+
+/*
+ * Description: This function sets the maximal number of terminated threads
+ * whose control blocks and stacks are kept, to be reused by later spawns
+ * without allocating. Cached threads above the new limit are released.
+ * The default is THREAD_CACHE_SIZE. It is an error to pass a negative limit.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_set_cache_limit(int max_cached);
+
+
+/*
+ * Description: This function releases cached terminated threads until at
+ * most keep of them remain. Threads with the largest stacks are released
+ * first. It is an error to pass a negative keep.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_trim_cache(int keep);
+
+
+/*
+ * Description: These functions do what read(), write(), accept() and
+ * connect() do, but block only the calling thread: the file descriptor is
+ * put in non-blocking mode, and whenever the operation would block, the
+ * calling thread is moved to the BLOCKED state until the file descriptor is
+ * ready, and other threads run meanwhile. A thread blocked this way is not
+ * resumed by uthread_resume. The non-blocking mode is shared with every copy
+ * of the file descriptor, including ones in other processes.
+ * Return value: As the corresponding system call. On failure, return -1 and
+ * set errno.
+*/
+ssize_t uthread_read(int fd, void *data, size_t count);
+ssize_t uthread_write(int fd, const void *data, size_t count);
+int uthread_accept(int sockfd, struct sockaddr *addr, socklen_t *addrlen);
+int uthread_connect(int sockfd, const struct sockaddr *addr, socklen_t addrlen);
+
+
+
+/*
+ * Description: These functions do what pread() and pwrite() do, but block
+ * only the calling thread: the request is queued to an io_uring instance,
+ * and the calling thread is moved to the BLOCKED state until it completes,
+ * while other threads run. Requests are submitted to the kernel in batches:
+ * all the requests queued until the next tick, or until no thread can run,
+ * are submitted together. If io_uring is not available, the system call is
+ * made directly, and blocks the process. If the calling thread is terminated
+ * while its request is in flight, the request still completes, and may still
+ * write to the buffer.
+ * Return value: As the corresponding system call. On failure, return -1 and
+ * set errno.
+*/
+ssize_t uthread_pread(int fd, void *data, size_t count, off_t offset);
+ssize_t uthread_pwrite(int fd, const void *data, size_t count, off_t offset);
+
+/*
+ * Description: This function blocks the calling thread for usec
+ * micro-seconds, while other threads run. The thread is moved to the BLOCKED
+ * state, and back to READY once the time has passed (the earliest tick after
+ * it, or the earliest time no other thread can run). A sleeping thread is not
+ * resumed by uthread_resume. It is an error to call this function with a
+ * negative usec.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_usec(int usec);
+
+
+/*
+ * Description: Like uthread_sleep_usec, but the calling thread sleeps until
+ * deadline, an absolute time of CLOCK_MONOTONIC. It is an error to call this
+ * function with an invalid deadline.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_sleep_until(const struct timespec *deadline);
+
+/*
+ * Description: This function initializes a mutex as unlocked. It is the same
+ * as initializing it with UTHREAD_MUTEX_INITIALIZER.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_init(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function locks a mutex. If it is held by another thread,
+ * the calling thread is moved to the BLOCKED state until the mutex is handed
+ * to it: threads get the mutex in the order they started waiting for it.
+ * Locking a mutex that no thread holds involves no system call and no
+ * critical section. It is an error to lock a mutex that the calling thread
+ * already holds.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_lock(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: Like uthread_mutex_lock, but fails instead of blocking if the
+ * mutex is held by a thread.
+ * Return value: On success, return 0. If the mutex is held, or on failure,
+ * return -1.
+*/
+int uthread_mutex_trylock(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function unlocks a mutex that the calling thread holds.
+ * If threads wait for it, it is handed to the first of them, which is moved
+ * to the READY state. It is an error to unlock a mutex that the calling
+ * thread does not hold.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_mutex_unlock(uthread_mutex_t *mutex);
+
+
+/*
+ * Description: This function initializes a condition variable. It is the
+ * same as initializing it with UTHREAD_COND_INITIALIZER.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_init(uthread_cond_t *cond);
+
+
+/*
+ * Description: This function unlocks mutex, which the calling thread must
+ * hold, and moves the calling thread to the BLOCKED state until cond is
+ * signaled. The thread returns holding the mutex again: a signaled thread
+ * waits for the mutex like uthread_mutex_lock does, without running first.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_wait(uthread_cond_t *cond, uthread_mutex_t *mutex);
+
+
+/*
+ * Description: uthread_cond_signal wakes up the thread that waits the
+ * longest for cond, and uthread_cond_broadcast wakes up all of them. Doing
+ * so when no thread waits involves no critical section.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_cond_signal(uthread_cond_t *cond);
+int uthread_cond_broadcast(uthread_cond_t *cond);
+
+
+/*
+ * Description: This function creates a channel that passes elements of
+ * elem_size bytes between threads, in the order they were sent. It buffers up
+ * to capacity elements; a channel with no capacity passes an element only
+ * when a sender meets a receiver.
+ * Return value: On success, return the channel. On failure, return NULL.
+*/
+uthread_chan_t *uthread_chan_create(size_t elem_size, size_t capacity);
+
+
+/*
+ * Description: This function frees a channel. It is an error to destroy a
+ * channel that threads wait in.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_chan_destroy(uthread_chan_t *chan);
+
+
+/*
+ * Description: uthread_chan_send copies an element into the channel. If it
+ * is full, the calling thread is moved to the BLOCKED state until a receiver
+ * takes the element. uthread_chan_recv copies the first element of the
+ * channel out. If it is empty, the calling thread is moved to the BLOCKED
+ * state until a sender copies an element straight to it. Waiting threads
+ * are served in FIFO order, and are not resumed by uthread_resume.
+ * Return value: On success, return 0. On failure, return -1 and set errno:
+ * EPIPE if the channel was closed (and, for uthread_chan_recv, is empty).
+*/
+int uthread_chan_send(uthread_chan_t *chan, const void *elem);
+int uthread_chan_recv(uthread_chan_t *chan, void *elem);
+
+
+/*
+ * Description: Like uthread_chan_send and uthread_chan_recv, but fail
+ * instead of blocking.
+ * Return value: On success, return 0. On failure, return -1 and set errno:
+ * EAGAIN if the channel is full (empty), EPIPE if it was closed.
+*/
+int uthread_chan_try_send(uthread_chan_t *chan, const void *elem);
+int uthread_chan_try_recv(uthread_chan_t *chan, void *elem);
+
+
+/*
+ * Description: uthread_chan_send_n sends count elements, blocking until all
+ * of them are in the channel or taken by receivers. uthread_chan_recv_n
+ * receives up to count elements, blocking only until there is at least one.
+ * Passing a batch wakes every waiting thread at most once, and the threads
+ * on the other side are handed as many elements as they asked for.
+ * Return value: On success, return the number of elements that were passed,
+ * which is less than count for uthread_chan_send_n only if the channel was
+ * closed meanwhile. On failure, return -1 and set errno, as
+ * uthread_chan_send and uthread_chan_recv.
+*/
+ssize_t uthread_chan_send_n(uthread_chan_t *chan, const void *elems,
+                            size_t count);
+ssize_t uthread_chan_recv_n(uthread_chan_t *chan, void *elems, size_t count);
+
+
+/*
+ * Description: This function closes a channel: sending fails from now on,
+ * and receiving fails once the channel is empty. Threads that wait in the
+ * channel are woken up.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_chan_close(uthread_chan_t *chan);
+
+
+/*
+ * Description: This function waits until one of num_cases cases is ready,
+ * and carries it out: an element is received or sent, a file descriptor is
+ * readable or writable, or a thread terminated (a thread that does not exist
+ * has terminated already; the ID has to be in range, and not the one of the
+ * main thread or of the calling thread). If none is ready, the calling thread is moved to
+ * the BLOCKED state, registered in all of them at once, until the first one
+ * becomes ready; its other registrations are then removed right away. If
+ * several cases are ready, the first of them is chosen. A case fails if its
+ * channel was closed (EPIPE, receiving only once the channel is empty) or its
+ * file descriptor was closed by uthread_close (EBADF); its error is set then.
+ * Return value: On success, return the index of the chosen case. On failure,
+ * return -1.
+*/
+int uthread_select(uthread_select_case_t *cases, int num_cases);
+
+
+/*
+ * Description: This function creates the pool of the library: num_workers
+ * threads, spawned as by uthread_spawn, that run the tasks submitted with
+ * uthread_submit in the order they were submitted. It is an error to create
+ * the pool while it exists, or if not all the workers can be spawned.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_pool_create(int num_workers);
+
+
+/*
+ * Description: This function queues a task that calls fn(arg) on a worker of
+ * the pool. Submitting does not block, and after the first tasks allocates
+ * nothing: a future is reused once its result is taken.
+ * Return value: On success, return the future of the task's result, which
+ * must be passed to uthread_future_get exactly once. On failure, return
+ * NULL.
+*/
+uthread_future_t *uthread_submit(void *(*fn)(void *), void *arg);
+
+
+/*
+ * Description: This function moves the calling thread to the BLOCKED state
+ * until the task of future returned, unless it already did, and releases the
+ * future. A worker must not wait for a task that is queued after its own.
+ * Return value: On success, return 0, and store what the task returned in
+ * *result if result is not NULL. On failure, return -1.
+*/
+int uthread_future_get(uthread_future_t *future, void **result);
+
+
+/*
+ * Description: This function destroys the pool: the calling thread waits
+ * until the workers ran the tasks that are queued and terminated. It is an
+ * error to destroy the pool from one of its workers, or if it does not
+ * exist.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_pool_destroy();
+
+
+/*
+ * Description: This function creates a thread-local storage key, whose value
+ * is NULL in every thread until the thread sets it with
+ * uthread_setspecific. When a thread is terminated or returns from its entry
+ * point, destructor (if not NULL) is called with each non-NULL value of the
+ * key. The destructors run in the thread that calls uthread_terminate, or in
+ * the thread itself when it returns, and if they set values again they are
+ * called again, up to UTHREAD_DESTRUCTOR_ITERATIONS times. It is an error to
+ * create more than UTHREAD_KEYS_MAX keys.
+ * Return value: On success, store the key in *key and return 0. On failure,
+ * return -1.
+*/
+int uthread_key_create(uthread_key_t *key, void (*destructor)(void *));
+
+
+/*
+ * Description: This function deletes a key. Its destructor is not called,
+ * and the key may be returned by uthread_key_create again.
+ * Return value: On success, return 0. On failure, return -1.
+*/
+int uthread_key_delete(uthread_key_t key);
+
+
+/*
+ * Description: These functions get and set the value of key in the RUNNING
+ * thread. A key that is out of range has the value NULL.
+ * Return value: uthread_getspecific returns the value. uthread_setspecific
+ * returns 0 on success and -1 on failure.
+*/
+void *uthread_getspecific(uthread_key_t key);
+int uthread_setspecific(uthread_key_t key, const void *value);
+
+/*
+ * Description: This function closes a file descriptor that was passed to
+ * the functions above. It must be used instead of close(), so that a new file
+ * descriptor with the same number is set up again. Threads blocked on the
+ * file descriptor are woken up, and their calls fail with EBADF.
+ * Return value: As close().
+*/
+int uthread_close(int fd);
+
+
 /*
  * Description: This function returns the thread ID of the calling thread.
  * Return value: The ID of the calling thread.
@@ -113,4 +619,59 @@ int uthread_get_total_quantums();
 */
 int uthread_get_quantums(int tid);
 
+
+/* The operations of the uthread_spawn template on a callable of type F: it is
+ * kept inside the thread if it fits, and on the heap otherwise. */
+template <typename F, bool Inline = (sizeof(F) <= UTHREAD_CLOSURE_SIZE &&
+                                     alignof(F) <= alignof(std::max_align_t))>
+struct uthread_closure
+{
+    static void construct(void *storage, void *callable)
+    {
+        new (storage) F(std::move(*(F *)callable));
+    }
+    static void run(void *storage) { (*(F *)storage)(); }
+    static void destroy(void *storage) { ((F *)storage)->~F(); }
+    static const uthread_closure_ops_t ops;
+};
+
+template <typename F>
+struct uthread_closure<F, false>
+{
+    static void construct(void *storage, void *callable)
+    {
+        *(F **)storage = new F(std::move(*(F *)callable));
+    }
+    static void run(void *storage) { (**(F **)storage)(); }
+    static void destroy(void *storage) { delete *(F **)storage; }
+    static const uthread_closure_ops_t ops;
+};
+
+template <typename F, bool Inline>
+const uthread_closure_ops_t uthread_closure<F, Inline>::ops =
+        {construct, run, destroy};
+
+template <typename F>
+const uthread_closure_ops_t uthread_closure<F, false>::ops =
+        {construct, run, destroy};
+
+/*
+ * Description: Like uthread_spawn, but the entry point is any callable with
+ * no arguments, such as a lambda that captures the state of the thread. The
+ * callable is moved into the thread, and destroyed when the thread is
+ * terminated. Callables of up to UTHREAD_CLOSURE_SIZE bytes are not
+ * allocated on the heap.
+ * Return value: On success, return the ID of the created thread.
+ * On failure, return -1.
+*/
+template <typename F>
+typename std::enable_if<!std::is_convertible<F, void (*)(void)>::value,
+                        int>::type
+uthread_spawn(F &&f)
+{
+    typedef typename std::decay<F>::type Callable;
+    Callable callable(std::forward<F>(f));
+    return uthread_spawn_closure(&uthread_closure<Callable>::ops, &callable);
+}
+
 #endif
\ No newline at end of file